@@ -0,0 +1,310 @@
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <limits.h>
+#include <sys/stat.h>
+#include <string>
+#include <iostream>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+
+#include "level.h"
+#include "level_generator.h"
+
+using namespace std;
+
+struct LevelStats {
+    int rooms;
+    int room_cells;
+    int corridor_cells;
+    int upstairs;
+    int downstairs;
+    int rejected_rooms;
+};
+
+static int number_of_levels = 1000;
+static unsigned int base_seed = 0;
+static int number_of_threads = 0;
+static string output_directory = "";
+static string archive_path = "";
+static int room_placement = RANDOM_PLACEMENT;
+static int do_benchmark = 0;
+static int benchmark_rooms = MAX_NUMBER_OF_ROOMS;
+static FILE * archive = NULL;
+static mutex archive_mutex;
+static atomic<int> next_level(0);
+static atomic<int> failed_writes(0);
+static vector<struct LevelStats> level_stats;
+
+void print_usage();
+void generate_levels();
+struct LevelStats get_level_stats(Level * level);
+void write_level_to_directory(Level * level, int index);
+void write_level_to_archive(Level * level, unsigned int seed);
+void print_stats(double seconds);
+void run_benchmark();
+void benchmark_placement(int placement, string name);
+
+int main(int argc, char *args[]) {
+    struct option longopts[] = { {"count", required_argument, NULL, 'n'},
+        {"seed", required_argument, NULL, 's'},
+        {"threads", required_argument, NULL, 't'},
+        {"output", required_argument, NULL, 'o'},
+        {"archive", required_argument, NULL, 'a'},
+        {"placement", required_argument, NULL, 'p'},
+        {"benchmark", no_argument, &do_benchmark, 1},
+        {"rooms", required_argument, NULL, 'r'},
+        {"help", no_argument, NULL, 'h'},
+        {0, 0, 0, 0}
+    };
+    int c;
+    while((c = getopt_long(argc, args, "n:s:t:o:a:p:r:h", longopts, NULL)) != -1) {
+        switch(c) {
+            case 'n':
+                number_of_levels = atoi(optarg);
+                break;
+            case 's':
+                base_seed = strtoul(optarg, NULL, 10);
+                break;
+            case 't':
+                number_of_threads = atoi(optarg);
+                break;
+            case 'o':
+                output_directory = optarg;
+                break;
+            case 'a':
+                archive_path = optarg;
+                break;
+            case 'p':
+                if (string(optarg).compare("bsp") == 0) {
+                    room_placement = BSP_PLACEMENT;
+                }
+                else if (string(optarg).compare("random") == 0) {
+                    room_placement = RANDOM_PLACEMENT;
+                }
+                else {
+                    print_usage();
+                    exit(1);
+                }
+                break;
+            case 'r':
+                benchmark_rooms = atoi(optarg);
+                break;
+            case 0:
+                break;
+            default:
+                print_usage();
+                exit(0);
+        }
+    }
+    if (number_of_levels < 1) {
+        print_usage();
+        exit(1);
+    }
+    if (do_benchmark) {
+        run_benchmark();
+        return 0;
+    }
+    if (number_of_threads < 1) {
+        number_of_threads = thread::hardware_concurrency();
+        if (number_of_threads < 1) {
+            number_of_threads = 1;
+        }
+    }
+    if (output_directory.length()) {
+        mkdir(output_directory.c_str(), 0777);
+        if (output_directory[output_directory.length() - 1] != '/') {
+            output_directory += "/";
+        }
+    }
+    if (archive_path.length()) {
+        archive = fopen(archive_path.c_str(), "wb+");
+        if (archive == NULL) {
+            cout << "Cannot open archive: " << archive_path << endl;
+            exit(1);
+        }
+        string archive_marker = "RLG327-BATCH";
+        uint32_t count = number_of_levels;
+        fwrite(archive_marker.c_str(), 1, archive_marker.length(), archive);
+        fwrite(&count, 1, 4, archive);
+    }
+
+    level_stats.resize(number_of_levels);
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    vector<thread> workers;
+    for (int i = 0; i < number_of_threads; i++) {
+        workers.push_back(thread(generate_levels));
+    }
+    for (size_t i = 0; i < workers.size(); i++) {
+        workers[i].join();
+    }
+    chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+
+    if (archive) {
+        fclose(archive);
+    }
+    print_stats(elapsed.count());
+    if (failed_writes > 0) {
+        cout << failed_writes << " levels could not be written" << endl;
+        return 1;
+    }
+    return 0;
+}
+
+void print_usage() {
+    printf("usage: batch_generate [--count=<number of levels>] [--seed=<base seed>] [--threads=<number of threads>] [--output=<directory>] [--archive=<file>] [--placement=random|bsp] [--benchmark [--rooms=<rooms per level>]]\n");
+}
+
+/*
+ * Worker loop. Level i is always generated from seed base_seed + i, so a
+ * batch is reproducible no matter how many threads share the work.
+ */
+void generate_levels() {
+    Level * level = new Level();
+    int index;
+    while ((index = next_level++) < number_of_levels) {
+        unsigned int seed = base_seed + index;
+        LevelGenerator generator(seed);
+        generator.room_placement = room_placement;
+        generator.generate(level);
+        level->depth = index;
+        level_stats[index] = get_level_stats(level);
+        level_stats[index].rejected_rooms = generator.rejected_rooms;
+        if (output_directory.length()) {
+            write_level_to_directory(level, index);
+        }
+        if (archive) {
+            write_level_to_archive(level, seed);
+        }
+    }
+    delete level;
+}
+
+struct LevelStats get_level_stats(Level * level) {
+    struct LevelStats stats;
+    stats.rooms = level->rooms.size();
+    stats.room_cells = 0;
+    stats.corridor_cells = 0;
+    stats.upstairs = 0;
+    stats.downstairs = 0;
+    for (int y = 0; y < HEIGHT; y++) {
+        for (int x = 0; x < WIDTH; x++) {
+            const string & type = level->board[y][x].type;
+            if (type.compare(TYPE_ROOM) == 0) {
+                stats.room_cells ++;
+            }
+            else if (type.compare(TYPE_CORRIDOR) == 0) {
+                stats.corridor_cells ++;
+            }
+            else if (type.compare(TYPE_UPSTAIR) == 0) {
+                stats.upstairs ++;
+            }
+            else if (type.compare(TYPE_DOWNSTAIR) == 0) {
+                stats.downstairs ++;
+            }
+        }
+    }
+    return stats;
+}
+
+void write_level_to_directory(Level * level, int index) {
+    char filename[32];
+    snprintf(filename, sizeof(filename), "dungeon_%05d", index);
+    string filepath = output_directory + filename;
+    FILE * fp = fopen(filepath.c_str(), "wb+");
+    if (fp == NULL) {
+        failed_writes ++;
+        return;
+    }
+    level->writeDungeonFile(fp);
+    fclose(fp);
+}
+
+/*
+ * Archive entries are the seed, the byte length and the serialized level.
+ * Workers append entries as they finish, so entries are not in seed order.
+ */
+void write_level_to_archive(Level * level, unsigned int seed) {
+    vector<uint8_t> buffer;
+    level->serialize(buffer);
+    uint32_t length = buffer.size();
+    lock_guard<mutex> lock(archive_mutex);
+    fwrite(&seed, 1, 4, archive);
+    fwrite(&length, 1, 4, archive);
+    fwrite(buffer.data(), 1, buffer.size(), archive);
+}
+
+void print_stats(double seconds) {
+    long total_rooms = 0;
+    long total_room_cells = 0;
+    long total_corridor_cells = 0;
+    long total_stairs = 0;
+    long total_rejected_rooms = 0;
+    int min_rooms = INT_MAX;
+    int max_rooms = 0;
+    int min_corridor_cells = INT_MAX;
+    int max_corridor_cells = 0;
+    for (size_t i = 0; i < level_stats.size(); i++) {
+        struct LevelStats stats = level_stats[i];
+        total_rooms += stats.rooms;
+        total_room_cells += stats.room_cells;
+        total_corridor_cells += stats.corridor_cells;
+        total_stairs += stats.upstairs + stats.downstairs;
+        total_rejected_rooms += stats.rejected_rooms;
+        min_rooms = min(min_rooms, stats.rooms);
+        max_rooms = max(max_rooms, stats.rooms);
+        min_corridor_cells = min(min_corridor_cells, stats.corridor_cells);
+        max_corridor_cells = max(max_corridor_cells, stats.corridor_cells);
+    }
+    double count = level_stats.size();
+    printf("Generated %d levels on %d threads in %.3f s (%.1f levels/s)\n",
+            number_of_levels, number_of_threads, seconds, count / seconds);
+    printf("Rooms per level: min %d, avg %.1f, max %d\n",
+            min_rooms, total_rooms / count, max_rooms);
+    printf("Corridor cells per level: min %d, avg %.1f, max %d\n",
+            min_corridor_cells, total_corridor_cells / count, max_corridor_cells);
+    printf("Room cells per level: avg %.1f (%.1f%% of the board)\n",
+            total_room_cells / count, 100.0 * total_room_cells / (count * HEIGHT * WIDTH));
+    printf("Stairs per level: avg %.1f\n", total_stairs / count);
+    printf("Rejected room candidates per level: avg %.1f\n", total_rejected_rooms / count);
+}
+
+/*
+ * Times only the room placement step of both backends on the same seeds, on
+ * one thread, asking each level for benchmark_rooms rooms.
+ */
+void run_benchmark() {
+    printf("Placing up to %d rooms on each of %d levels\n", benchmark_rooms, number_of_levels);
+    benchmark_placement(RANDOM_PLACEMENT, "random");
+    benchmark_placement(BSP_PLACEMENT, "bsp");
+}
+
+void benchmark_placement(int placement, string name) {
+    Level * level = new Level();
+    long total_rooms = 0;
+    long total_rejected_rooms = 0;
+    chrono::duration<double> elapsed(0);
+    for (int i = 0; i < number_of_levels; i++) {
+        LevelGenerator generator(base_seed + i);
+        generator.initializeBoard(level);
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        if (placement == BSP_PLACEMENT) {
+            generator.digRoomsWithBSP(level, benchmark_rooms);
+        }
+        else {
+            generator.digRooms(level, benchmark_rooms);
+        }
+        elapsed += chrono::steady_clock::now() - start;
+        total_rooms += level->rooms.size();
+        total_rejected_rooms += generator.rejected_rooms;
+    }
+    delete level;
+    double milliseconds = elapsed.count() * 1000;
+    printf("%-6s  %.3f ms  %.1f rooms/level  %.1f rooms/ms  %.1f rejected/level\n",
+            name.c_str(), milliseconds, (double) total_rooms / number_of_levels,
+            total_rooms / milliseconds, (double) total_rejected_rooms / number_of_levels);
+}
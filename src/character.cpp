@@ -28,11 +28,6 @@ bool Character :: isAlive() {
     return hitpoints > 0;
 }
 
-bool Character :: is(Character * other) {
-    return other != NULL && id.compare(other->id) == 0;
-}
-
 Character :: Character() {
-    id = generateRandomString(40);
     turn_health_regenerated = 0;
 }
@@ -5,16 +5,14 @@
 
 class Character : public BoardElement {
     public:
-        string id;
         int turn_health_regenerated;
         int speed;
         int max_hitpoints;
         int hitpoints;
         int experience;
-        Numeric * attack_damage;
+        Numeric attack_damage;
         int damage(int amount);
         bool isAlive();
-        bool is(Character * other);
         void regenerateHealth(int turn);
         int getDefense();
         bool hitWillConnect();
@@ -0,0 +1,224 @@
+#include <stdio.h>
+#include <string.h>
+#include <thread>
+#include <atomic>
+#include "description_scanner.h"
+
+#define MAX_DESCRIPTION_LINE_LENGTH 77
+#define MIN_BLOCKS_PER_THREAD 32
+
+bool Slice :: equals(const char * str) const {
+    return strlen(str) == length && memcmp(str, data, length) == 0;
+}
+
+string Slice :: toString() const {
+    return string(data, length);
+}
+
+DescriptionScanner :: DescriptionScanner() {
+    data = NULL;
+    size = 0;
+    offset = 0;
+}
+
+/*
+ * Scans one block of another scanner's buffer, which must outlive this one.
+ */
+DescriptionScanner :: DescriptionScanner(const Slice & block) {
+    data = block.data;
+    size = block.length;
+    offset = 0;
+}
+
+bool DescriptionScanner :: readFile(const string & filepath) {
+    FILE * fp = fopen(filepath.c_str(), "rb");
+    if (fp == NULL) {
+        return false;
+    }
+    fseek(fp, 0, SEEK_END);
+    long file_size = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    buffer.resize(file_size > 0 ? file_size : 0);
+    size_t read = fread(&buffer[0], 1, buffer.size(), fp);
+    fclose(fp);
+    buffer.resize(read);
+    data = buffer.data();
+    size = buffer.size();
+    offset = 0;
+    return true;
+}
+
+/*
+ * Hands out the next line without its newline. Returns false at the end of
+ * the buffer.
+ */
+bool DescriptionScanner :: nextLine(Slice & line) {
+    if (offset >= size) {
+        return false;
+    }
+    const char * start = data + offset;
+    const char * newline = (const char *) memchr(start, '\n', size - offset);
+    if (newline) {
+        line.data = start;
+        line.length = newline - start;
+        offset += line.length + 1;
+    }
+    else {
+        line.data = start;
+        line.length = size - offset;
+        offset = size;
+    }
+    return true;
+}
+
+static bool is_description_keyword(const Slice & line) {
+    return line.length >= 4 && memcmp(line.data, "DESC", 4) == 0 && (line.length == 4 || line.data[4] == ' ');
+}
+
+/*
+ * Splits the rest of the buffer into blocks that each start at a begin_line
+ * and run up to the next one, so they can be parsed independently. Anything
+ * before the first begin_line is skipped, as is a begin_line inside a
+ * description.
+ */
+vector<Slice> DescriptionScanner :: splitBlocks(const char * begin_line) {
+    vector<Slice> blocks;
+    bool in_description = false;
+    Slice line;
+    while (nextLine(line)) {
+        if (in_description) {
+            in_description = !line.equals(".");
+        }
+        else if (is_description_keyword(line)) {
+            in_description = true;
+        }
+        else if (line.equals(begin_line)) {
+            if (blocks.size()) {
+                blocks.back().length = line.data - blocks.back().data;
+            }
+            Slice block;
+            block.data = line.data;
+            block.length = data + size - line.data;
+            blocks.push_back(block);
+        }
+    }
+    return blocks;
+}
+
+/*
+ * Reads the lines following a DESC keyword up to the terminating "." and
+ * joins them with newlines.
+ */
+string DescriptionScanner :: readDescription() {
+    string description;
+    Slice line;
+    while (nextLine(line) && !line.equals(".")) {
+        if (line.length > MAX_DESCRIPTION_LINE_LENGTH) {
+            throw "Description line too long";
+        }
+        if (description.length()) {
+            description += '\n';
+        }
+        description.append(line.data, line.length);
+    }
+    return description;
+}
+
+/*
+ * Matches the first word of the line against the table. Returns the field of
+ * the matching entry, with value set to the rest of the line, or -1.
+ */
+int DescriptionScanner :: lookupKeyword(const KeywordEntry * table, int table_size, const Slice & line, Slice & value) {
+    const char * space = (const char *) memchr(line.data, ' ', line.length);
+    size_t keyword_length = space ? space - line.data : line.length;
+    for (int i = 0; i < table_size; i++) {
+        const char * keyword = table[i].keyword;
+        if (strlen(keyword) == keyword_length && memcmp(keyword, line.data, keyword_length) == 0) {
+            value.data = space ? space + 1 : line.data + line.length;
+            value.length = line.length - (value.data - line.data);
+            return table[i].field;
+        }
+    }
+    return -1;
+}
+
+static int parse_int(const char * & cursor, const char * end) {
+    bool negative = false;
+    if (cursor < end && (*cursor == '-' || *cursor == '+')) {
+        negative = *cursor == '-';
+        cursor++;
+    }
+    if (cursor >= end || *cursor < '0' || *cursor > '9') {
+        throw "Invalid dice value";
+    }
+    int value = 0;
+    while (cursor < end && *cursor >= '0' && *cursor <= '9') {
+        value = value * 10 + (*cursor - '0');
+        cursor++;
+    }
+    return negative ? -value : value;
+}
+
+/*
+ * Parses a dice value of the form <base>+<dice>d<sides>.
+ */
+Numeric DescriptionScanner :: parseNumeric(const Slice & value) {
+    const char * cursor = value.data;
+    const char * end = value.data + value.length;
+    int base = parse_int(cursor, end);
+    if (cursor >= end || *cursor != '+') {
+        throw "Invalid dice value";
+    }
+    cursor++;
+    int dice = parse_int(cursor, end);
+    if (cursor >= end || *cursor != 'd') {
+        throw "Invalid dice value";
+    }
+    cursor++;
+    int sides = parse_int(cursor, end);
+    return Numeric(base, dice, sides);
+}
+
+vector<string> DescriptionScanner :: splitWords(const Slice & value) {
+    vector<string> words;
+    const char * cursor = value.data;
+    const char * end = value.data + value.length;
+    while (cursor < end) {
+        const char * space = (const char *) memchr(cursor, ' ', end - cursor);
+        const char * word_end = space ? space : end;
+        if (word_end > cursor) {
+            words.push_back(string(cursor, word_end - cursor));
+        }
+        cursor = word_end + 1;
+    }
+    return words;
+}
+
+/*
+ * Calls parse_block for every block index. Large packs are spread over worker
+ * threads that pull the next index from a shared counter; parse_block must
+ * only touch its own block's result.
+ */
+void for_each_block(size_t number_of_blocks, const function<void(size_t)> & parse_block) {
+    size_t number_of_threads = thread::hardware_concurrency();
+    number_of_threads = min(number_of_threads, number_of_blocks / MIN_BLOCKS_PER_THREAD);
+    if (number_of_threads < 2) {
+        for (size_t i = 0; i < number_of_blocks; i++) {
+            parse_block(i);
+        }
+        return;
+    }
+    atomic<size_t> next_block(0);
+    vector<thread> workers;
+    for (size_t i = 0; i < number_of_threads; i++) {
+        workers.push_back(thread([&]() {
+            size_t index;
+            while ((index = next_block++) < number_of_blocks) {
+                parse_block(index);
+            }
+        }));
+    }
+    for (size_t i = 0; i < workers.size(); i++) {
+        workers[i].join();
+    }
+}
@@ -0,0 +1,53 @@
+#ifndef DESCRIPTION_SCANNER_H
+#define DESCRIPTION_SCANNER_H
+
+#include <string>
+#include <vector>
+#include <functional>
+#include "numeric.h"
+
+using namespace std;
+
+/*
+ * A view of part of the scanner's buffer. Nothing is copied until toString.
+ */
+struct Slice {
+    const char * data;
+    size_t length;
+    bool equals(const char * str) const;
+    string toString() const;
+};
+
+struct KeywordEntry {
+    const char * keyword;
+    int field;
+};
+
+/*
+ * Single pass scanner shared by the monster and object description parsers.
+ * The whole file is read into one buffer and handed out line by line as
+ * slices; keywords are matched against a table instead of by building and
+ * comparing strings.
+ */
+class DescriptionScanner {
+    private:
+        string buffer;
+        const char * data;
+        size_t size;
+        size_t offset;
+
+    public:
+        bool readFile(const string & filepath);
+        bool nextLine(Slice & line);
+        vector<Slice> splitBlocks(const char * begin_line);
+        string readDescription();
+        static int lookupKeyword(const KeywordEntry * table, int table_size, const Slice & line, Slice & value);
+        static Numeric parseNumeric(const Slice & value);
+        static vector<string> splitWords(const Slice & value);
+        DescriptionScanner();
+        DescriptionScanner(const Slice & block);
+};
+
+void for_each_block(size_t number_of_blocks, const function<void(size_t)> & parse_block);
+
+#endif
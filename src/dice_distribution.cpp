@@ -0,0 +1,145 @@
+#include <random>
+#include "dice_distribution.h"
+
+DiceRandom :: DiceRandom(uint64_t seed) {
+    // splitmix64 spreads similar seeds apart; xorshift must not start at 0
+    seed += 0x9e3779b97f4a7c15ULL;
+    seed = (seed ^ (seed >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    seed = (seed ^ (seed >> 27)) * 0x94d049bb133111ebULL;
+    state = seed ^ (seed >> 31);
+    if (state == 0) {
+        state = 0x9e3779b97f4a7c15ULL;
+    }
+}
+
+uint32_t DiceRandom :: next() {
+    state ^= state >> 12;
+    state ^= state << 25;
+    state ^= state >> 27;
+    return (state * 0x2545f4914f6cdd1dULL) >> 32;
+}
+
+/*
+ * Uniform integer in [0, n) without modulo bias (Lemire's multiply and
+ * reject).
+ */
+int DiceRandom :: uniform(int n) {
+    uint32_t range = n;
+    uint64_t product = (uint64_t) next() * range;
+    uint32_t low = (uint32_t) product;
+    if (low < range) {
+        uint32_t threshold = -range % range;
+        while (low < threshold) {
+            product = (uint64_t) next() * range;
+            low = (uint32_t) product;
+        }
+    }
+    return product >> 32;
+}
+
+DiceRandom & thread_dice_random() {
+    static thread_local DiceRandom random(((uint64_t) random_device()() << 32) ^ random_device()());
+    return random;
+}
+
+DiceDistribution :: DiceDistribution(const Numeric & numeric) {
+    base = numeric.base;
+    dice = numeric.dice;
+    sides = numeric.sides;
+    if (dice <= 0 || sides <= 0) {
+        dice = 0;
+        sides = 1;
+    }
+    long outcomes = (long) dice * (sides - 1) + 1;
+    if (outcomes == 1 || outcomes > MAX_TABLE_OUTCOMES) {
+        return;
+    }
+    // Probabilities of each total above the minimum, one die at a time. Each
+    // step is a sliding window sum over the previous step.
+    vector<double> probabilities(1, 1.0);
+    for (int die = 0; die < dice; die++) {
+        vector<double> next(probabilities.size() + sides - 1, 0.0);
+        double window = 0;
+        for (size_t i = 0; i < next.size(); i++) {
+            if (i < probabilities.size()) {
+                window += probabilities[i];
+            }
+            if (i >= (size_t) sides) {
+                window -= probabilities[i - sides];
+            }
+            next[i] = window / sides;
+        }
+        probabilities.swap(next);
+    }
+    // Vose's alias method: every column keeps its own outcome with
+    // probability alias_threshold / 2^32 and otherwise yields its alias.
+    vector<double> scaled(outcomes);
+    vector<int> small;
+    vector<int> large;
+    for (long i = 0; i < outcomes; i++) {
+        scaled[i] = probabilities[i] * outcomes;
+        if (scaled[i] < 1.0) {
+            small.push_back(i);
+        }
+        else {
+            large.push_back(i);
+        }
+    }
+    alias_threshold.assign(outcomes, UINT32_MAX);
+    alias_outcome.resize(outcomes);
+    for (long i = 0; i < outcomes; i++) {
+        alias_outcome[i] = i;
+    }
+    while (small.size() && large.size()) {
+        int less = small.back();
+        int more = large.back();
+        small.pop_back();
+        alias_threshold[less] = (uint32_t) (scaled[less] * 4294967296.0);
+        alias_outcome[less] = more;
+        scaled[more] -= 1.0 - scaled[less];
+        if (scaled[more] < 1.0) {
+            large.pop_back();
+            small.push_back(more);
+        }
+    }
+}
+
+// Always rolls 0
+DiceDistribution :: DiceDistribution() : DiceDistribution(Numeric(0, 0, 0)) {
+}
+
+int DiceDistribution :: roll(DiceRandom & random) const {
+    if (alias_threshold.size()) {
+        int column = ((uint64_t) random.next() * alias_threshold.size()) >> 32;
+        int index = random.next() < alias_threshold[column] ? column : alias_outcome[column];
+        return base + dice + index;
+    }
+    int total = base;
+    if (sides > 1) {
+        for (int i = 0; i < dice; i++) {
+            total += 1 + random.uniform(sides);
+        }
+    }
+    else {
+        total += dice;
+    }
+    return total;
+}
+
+void DiceDistribution :: roll(int n, int * out, DiceRandom & random) const {
+    for (int i = 0; i < n; i++) {
+        out[i] = roll(random);
+    }
+}
+
+int DiceDistribution :: getMin() const {
+    return base + dice;
+}
+
+int DiceDistribution :: getMax() const {
+    return base + dice * sides;
+}
+
+double DiceDistribution :: getMean() const {
+    return base + dice * (sides + 1) / 2.0;
+}
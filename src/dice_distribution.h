@@ -0,0 +1,54 @@
+#ifndef DICE_DISTRIBUTION_H
+#define DICE_DISTRIBUTION_H
+
+#include <stdint.h>
+#include <vector>
+#include "numeric.h"
+
+using namespace std;
+
+#define MAX_TABLE_OUTCOMES 4096
+#define MAX_CACHED_DISTRIBUTIONS 64
+
+/*
+ * Small, fast generator (xorshift64*) used for dice. Each thread gets its own
+ * through thread_dice_random(); simulations can seed their own for
+ * reproducible runs.
+ */
+class DiceRandom {
+    private:
+        uint64_t state;
+
+    public:
+        uint32_t next();
+        int uniform(int n);
+        DiceRandom(uint64_t seed);
+};
+
+DiceRandom & thread_dice_random();
+
+/*
+ * The distribution of <base>+<dice>d<sides>, compiled once and rolled many
+ * times. Dice whose sums have at most MAX_TABLE_OUTCOMES outcomes are sampled
+ * from an alias table in constant time; larger ones fall back to summing the
+ * individual dice.
+ */
+class DiceDistribution {
+    private:
+        int base;
+        int dice;
+        int sides;
+        vector<uint32_t> alias_threshold;
+        vector<int> alias_outcome;
+
+    public:
+        int roll(DiceRandom & random) const;
+        void roll(int n, int * out, DiceRandom & random) const;
+        int getMin() const;
+        int getMax() const;
+        double getMean() const;
+        DiceDistribution(const Numeric & numeric);
+        DiceDistribution();
+};
+
+#endif
@@ -0,0 +1,125 @@
+#ifndef ENTITY_POOL_H
+#define ENTITY_POOL_H
+
+#include <stddef.h>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+using namespace std;
+
+#define ENTITY_POOL_BLOCK_SIZE 64
+
+/*
+ * Typed pool for the monsters and objects of one level. Entities live in
+ * blocks of ENTITY_POOL_BLOCK_SIZE slots; destroyed slots are reused and
+ * clear() releases every entity at once while keeping the blocks, so filling
+ * a level costs a handful of allocations instead of one per entity.
+ */
+template <typename T>
+class EntityPool {
+    private:
+        struct Slot {
+            typename aligned_storage<sizeof(T), alignof(T)>::type storage;
+            bool live;
+        };
+        vector<Slot *> blocks;
+        vector<Slot *> free_slots;
+        size_t live_count;
+        void addBlock();
+        EntityPool(const EntityPool &);
+        EntityPool & operator=(const EntityPool &);
+
+    public:
+        T * create();
+        T * create(const T & entity);
+        void destroy(T * entity);
+        void clear();
+        size_t size() const;
+        EntityPool();
+        ~EntityPool();
+};
+
+template <typename T>
+EntityPool<T> :: EntityPool() {
+    live_count = 0;
+}
+
+template <typename T>
+EntityPool<T> :: ~EntityPool() {
+    clear();
+    for (size_t i = 0; i < blocks.size(); i++) {
+        delete [] blocks[i];
+    }
+}
+
+template <typename T>
+void EntityPool<T> :: addBlock() {
+    Slot * block = new Slot[ENTITY_POOL_BLOCK_SIZE];
+    blocks.push_back(block);
+    for (int i = ENTITY_POOL_BLOCK_SIZE - 1; i >= 0; i--) {
+        block[i].live = false;
+        free_slots.push_back(&block[i]);
+    }
+}
+
+template <typename T>
+T * EntityPool<T> :: create() {
+    if (!free_slots.size()) {
+        addBlock();
+    }
+    Slot * slot = free_slots.back();
+    T * entity = new (&slot->storage) T();
+    free_slots.pop_back();
+    slot->live = true;
+    live_count ++;
+    return entity;
+}
+
+template <typename T>
+T * EntityPool<T> :: create(const T & other) {
+    if (!free_slots.size()) {
+        addBlock();
+    }
+    Slot * slot = free_slots.back();
+    T * entity = new (&slot->storage) T(other);
+    free_slots.pop_back();
+    slot->live = true;
+    live_count ++;
+    return entity;
+}
+
+/*
+ * The entity must have come from this pool.
+ */
+template <typename T>
+void EntityPool<T> :: destroy(T * entity) {
+    Slot * slot = reinterpret_cast<Slot *>(entity);
+    entity->~T();
+    slot->live = false;
+    free_slots.push_back(slot);
+    live_count --;
+}
+
+template <typename T>
+void EntityPool<T> :: clear() {
+    free_slots.clear();
+    for (size_t i = blocks.size(); i-- > 0;) {
+        for (int j = ENTITY_POOL_BLOCK_SIZE - 1; j >= 0; j--) {
+            Slot * slot = &blocks[i][j];
+            if (slot->live) {
+                reinterpret_cast<T *>(&slot->storage)->~T();
+                slot->live = false;
+            }
+            free_slots.push_back(slot);
+        }
+    }
+    live_count = 0;
+}
+
+template <typename T>
+size_t EntityPool<T> :: size() const {
+    return live_count;
+}
+
+#endif
@@ -0,0 +1,207 @@
+#include <string.h>
+#include <chrono>
+#include "event_log.h"
+
+static const char * EVENT_TYPE_NAMES[] = {
+    "player_miss",
+    "player_hit",
+    "monster_killed",
+    "monster_move",
+    "monster_attack",
+    "stairs",
+    "pickup"
+};
+
+GameEvent :: GameEvent() {
+    memset(this, 0, sizeof(GameEvent));
+}
+
+GameEvent :: GameEvent(int type, int depth, int x, int y) {
+    memset(this, 0, sizeof(GameEvent));
+    this->type = type;
+    this->depth = depth;
+    this->x = x;
+    this->y = y;
+}
+
+void GameEvent :: setName(const string & text) {
+    strncpy(name, text.c_str(), EVENT_NAME_LENGTH - 1);
+    name[EVENT_NAME_LENGTH - 1] = '\0';
+}
+
+EventQueue :: EventQueue() : head(0), tail(0) {
+}
+
+bool EventQueue :: push(const GameEvent & event) {
+    size_t position = tail.load(memory_order_relaxed);
+    if (position - head.load(memory_order_acquire) == EVENT_QUEUE_CAPACITY) {
+        return false;
+    }
+    events[position & (EVENT_QUEUE_CAPACITY - 1)] = event;
+    tail.store(position + 1, memory_order_release);
+    return true;
+}
+
+bool EventQueue :: pop(GameEvent & event) {
+    size_t position = head.load(memory_order_relaxed);
+    if (position == tail.load(memory_order_acquire)) {
+        return false;
+    }
+    event = events[position & (EVENT_QUEUE_CAPACITY - 1)];
+    head.store(position + 1, memory_order_release);
+    return true;
+}
+
+bool EventQueue :: isEmpty() const {
+    return head.load(memory_order_acquire) == tail.load(memory_order_acquire);
+}
+
+EventLog :: EventLog() : running(false), dropped(0), writer_sleeping(false) {
+    file = NULL;
+    file_bytes = 0;
+}
+
+EventLog :: ~EventLog() {
+    close();
+}
+
+bool EventLog :: open(const string & path) {
+    if (isOpen()) {
+        return true;
+    }
+    file = fopen(path.c_str(), "a");
+    if (file == NULL) {
+        return false;
+    }
+    this->path = path;
+    fseek(file, 0, SEEK_END);
+    file_bytes = ftell(file);
+    dropped = 0;
+    running = true;
+    writer = thread(&EventLog::writeEvents, this);
+    return true;
+}
+
+/*
+ * Stops the writer once it has written everything recorded so far.
+ */
+void EventLog :: close() {
+    if (!isOpen()) {
+        return;
+    }
+    running = false;
+    {
+        lock_guard<mutex> lock(wake_mutex);
+        wake.notify_one();
+    }
+    writer.join();
+    if (file == NULL) {
+        return;
+    }
+    if (dropped) {
+        fprintf(file, "{\"event\":\"dropped\",\"count\":%lu}\n", dropped.load());
+    }
+    fclose(file);
+    file = NULL;
+}
+
+bool EventLog :: isOpen() const {
+    return running.load(memory_order_relaxed);
+}
+
+void EventLog :: record(const GameEvent & event) {
+    if (!isOpen()) {
+        return;
+    }
+    GameEvent stamped = event;
+    stamped.time_us = chrono::duration_cast<chrono::microseconds>(chrono::system_clock::now().time_since_epoch()).count();
+    if (!queue.push(stamped)) {
+        dropped.fetch_add(1, memory_order_relaxed);
+        return;
+    }
+    // Pairs with the fence in writeEvents: either the writer sees this event
+    // before it sleeps or this sees writer_sleeping and wakes it. Clearing
+    // the flag here wakes a sleeping writer once rather than on every event
+    // recorded before it gets to run.
+    atomic_thread_fence(memory_order_seq_cst);
+    if (writer_sleeping.load(memory_order_relaxed) && writer_sleeping.exchange(false, memory_order_relaxed)) {
+        lock_guard<mutex> lock(wake_mutex);
+        wake.notify_one();
+    }
+}
+
+void EventLog :: writeEvents() {
+    GameEvent event;
+    while (true) {
+        // Checked before draining so that events recorded before close() are
+        // still written on the last pass.
+        bool stopping = !running.load(memory_order_acquire);
+        bool wrote = false;
+        while (queue.pop(event)) {
+            writeEvent(event);
+            wrote = true;
+        }
+        if (wrote && file) {
+            fflush(file);
+        }
+        if (stopping) {
+            return;
+        }
+        unique_lock<mutex> lock(wake_mutex);
+        writer_sleeping.store(true, memory_order_relaxed);
+        atomic_thread_fence(memory_order_seq_cst);
+        if (queue.isEmpty() && running.load(memory_order_acquire)) {
+            wake.wait(lock);
+        }
+        writer_sleeping.store(false, memory_order_relaxed);
+    }
+}
+
+void EventLog :: writeEvent(const GameEvent & event) {
+    if (file == NULL) { // rotation failed to reopen the log
+        return;
+    }
+    string name;
+    for (const char * c = event.name; *c; c++) {
+        if (*c == '"' || *c == '\\') {
+            name += '\\';
+        }
+        if ((unsigned char) *c >= 0x20) {
+            name += *c;
+        }
+    }
+    int written = fprintf(file, "{\"t\":%lld,\"event\":\"%s\",\"depth\":%d,\"x\":%d,\"y\":%d",
+                          (long long) event.time_us, EVENT_TYPE_NAMES[event.type], event.depth, event.x, event.y);
+    switch (event.type) {
+        case EVENT_MONSTER_MOVE:
+            written += fprintf(file, ",\"to_x\":%d,\"to_y\":%d", event.to_x, event.to_y);
+            break;
+        case EVENT_PLAYER_HIT:
+        case EVENT_MONSTER_ATTACK:
+            written += fprintf(file, ",\"amount\":%d,\"remaining\":%d", event.amount, event.remaining);
+            break;
+        case EVENT_MONSTER_KILLED:
+            written += fprintf(file, ",\"experience\":%d", event.amount);
+            break;
+        case EVENT_STAIRS:
+            written += fprintf(file, ",\"to_depth\":%d", event.amount);
+            break;
+        default:
+            break;
+    }
+    written += fprintf(file, ",\"name\":\"%s\"}\n", name.c_str());
+    file_bytes += written;
+    if (file_bytes >= EVENT_LOG_MAX_BYTES) {
+        rotate();
+    }
+}
+
+void EventLog :: rotate() {
+    fclose(file);
+    for (int i = EVENT_LOG_BACKUPS; i > 1; i--) {
+        rename((path + "." + to_string(i - 1)).c_str(), (path + "." + to_string(i)).c_str());
+    }
+    rename(path.c_str(), (path + ".1").c_str());
+    file = fopen(path.c_str(), "w");
+    file_bytes = 0;
+}
@@ -0,0 +1,99 @@
+#ifndef EVENT_LOG_H
+#define EVENT_LOG_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+
+using namespace std;
+
+#define EVENT_QUEUE_CAPACITY 4096 // must be a power of two
+#define EVENT_NAME_LENGTH 32
+#define EVENT_LOG_MAX_BYTES (8 * 1024 * 1024)
+#define EVENT_LOG_BACKUPS 3
+
+enum EventType {
+    EVENT_PLAYER_MISS,
+    EVENT_PLAYER_HIT,
+    EVENT_MONSTER_KILLED,
+    EVENT_MONSTER_MOVE,
+    EVENT_MONSTER_ATTACK,
+    EVENT_STAIRS,
+    EVENT_PICKUP
+};
+
+/*
+ * One game event, fixed size so it can be copied through the queue without
+ * allocating. Fields that do not apply to an event type stay zero.
+ */
+struct GameEvent {
+    int64_t time_us;
+    int type;
+    int depth;
+    int x;
+    int y;
+    int to_x;
+    int to_y;
+    int amount;
+    int remaining;
+    char name[EVENT_NAME_LENGTH];
+    void setName(const string & text);
+    GameEvent();
+    GameEvent(int type, int depth, int x, int y);
+};
+
+/*
+ * Lock-free ring for exactly one producer (the game thread) and one consumer
+ * (the writer thread).
+ */
+class EventQueue {
+    private:
+        GameEvent events[EVENT_QUEUE_CAPACITY];
+        alignas(64) atomic<size_t> head;
+        alignas(64) atomic<size_t> tail;
+
+    public:
+        bool push(const GameEvent & event);
+        bool pop(GameEvent & event);
+        bool isEmpty() const;
+        EventQueue();
+};
+
+/*
+ * Newline-delimited JSON log of game events. record() only stamps the event
+ * and pushes it onto the queue; a background thread formats and writes it,
+ * rotating the file to <path>.1 .. <path>.EVENT_LOG_BACKUPS once it reaches
+ * EVENT_LOG_MAX_BYTES. Events are dropped and counted, never waited on, if
+ * the writer falls behind. The writer blocks while the queue is empty; record
+ * only takes the lock to wake it when writer_sleeping is set.
+ */
+class EventLog {
+    private:
+        EventQueue queue;
+        atomic<bool> running;
+        atomic<unsigned long> dropped;
+        atomic<bool> writer_sleeping;
+        mutex wake_mutex;
+        condition_variable wake;
+        thread writer;
+        string path;
+        FILE * file;
+        long file_bytes;
+        void writeEvents();
+        void writeEvent(const GameEvent & event);
+        void rotate();
+
+    public:
+        bool open(const string & path);
+        void close();
+        bool isOpen() const;
+        void record(const GameEvent & event);
+        EventLog();
+        ~EventLog();
+};
+
+#endif
@@ -1,4 +1,3 @@
-#include <future>
 #include <stdint.h>
 #include <string.h>
 #include <getopt.h>
@@ -18,6 +17,10 @@
 #include <map>
 #include <cmath>
 #include <thread>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <memory>
 #include <typeinfo>
 
 #include "util.h"
@@ -29,75 +32,108 @@
 #include "player.h"
 #include "message.h"
 #include "board_element.h"
+#include "level.h"
+#include "level_cache.h"
+#include "level_generator.h"
+#include "hud.h"
+#include "template_cache.h"
+#include "event_log.h"
+#include "profiler.h"
+#include "job_scheduler.h"
 
 #include "priority_queue.h"
 
-#define HEIGHT 105
-#define WIDTH 160
 #define NCURSES_HEIGHT 20
 #define NCURSES_WIDTH 80
-#define IMMUTABLE_ROCK 255
-#define ROCK 200
-#define ROOM 0
-#define CORRIDOR 0
-#define MIN_NUMBER_OF_ROOMS 25
-#define MAX_NUMBER_OF_ROOMS 40
-#define MIN_ROOM_WIDTH 7
-#define DEFAULT_MAX_ROOM_WIDTH 20
-#define MIN_ROOM_HEIGHT 5
-#define DEFAULT_MAX_ROOM_HEIGHT 15
 #define MIN_NUMBER_OF_MONSTERS 5
 #define MAX_NUMBER_OF_MONSTERS 25
+#define STAIRS_UP 0
+#define STAIRS_DOWN 1
+#define OVERLAY_WIDTH 36
 using namespace std;
 
-static const string TYPE_ROOM = "room";
-static const string TYPE_CORRIDOR = "corridor";
-static const string TYPE_ROCK = "rock";
-static const string TYPE_UPSTAIR = "upstair";
-static const string TYPE_DOWNSTAIR = "downstair";
-
-typedef struct {
-    int tunneling_distance;
-    int non_tunneling_distance;
-    int hardness;
-    string type;
-    int x;
-    int y;
-    Monster *monster;
-    Object * object;
-} Board_Cell;
-
-struct Room {
-    int start_x;
-    int end_x;
-    int start_y;
-    int end_y;
-    bool has_explored;
-};
-
-static Board_Cell board[HEIGHT][WIDTH];
-static Board_Cell player_board[HEIGHT][WIDTH];
+static Level * level;
+static Board_Cell (* board)[WIDTH];
+static Board_Cell (* player_board)[WIDTH];
+static LevelCache level_cache;
+/*
+ * Where each staircase leads, by the level it is on and its cell. Stairs
+ * going back towards the level a level was first entered from all lead back
+ * there.
+ */
+static map<pair<LevelKey, int>, LevelKey> stair_links;
+static map<LevelKey, LevelKey> entered_from;
+static int next_stair = 1;
 static vector<struct Coordinate> placeable_areas;
 static struct Coordinate ncurses_player_coord;
 static struct Coordinate ncurses_start_coord;
-static vector<struct Room> rooms;
-static vector<Monster *> monsters;
 static vector<MonsterTemplate> monster_templates;
-static vector<Object *> objects;
 static vector<ObjectTemplate> object_templates;
 static PriorityQueue game_queue;
 static map<string, int> color_map;
 static Player * player;
-static vector<Message *> all_messages;
+static MessageLog message_log;
+static EventLog event_log;
+static Hud hud;
 
 string RLG_DIRECTORY = "";
 static int IS_CONTROL_MODE = 1;
 static int DO_QUIT = 0;
 static int DO_SAVE = 0;
 static int DO_LOAD = 0;
+static int USE_BSP = 0;
+static int DO_LOG_EVENTS = 0;
+static int DO_TRACE = 0;
+static int SHOW_OVERLAY = 0;
+
+/*
+ * What the performance overlay shows about the last turn, taken from the
+ * profiler's counters whenever the player's turn comes up.
+ */
+struct TurnStats {
+    uint64_t monster_ns;
+    uint64_t allocations;
+    uint64_t monster_ns_mark;
+    uint64_t allocations_mark;
+};
+static TurnStats turn_stats;
+static unsigned int distance_generation = 0;
+static int64_t distance_updated_ms = 0;
+
+/*
+ * The player's distance maps are recomputed by a job when the player moves
+ * or a monster tunnels, never in place: the job works on a snapshot of the
+ * hardness map and leaves its result here for the game thread to copy into
+ * the board between turns. The snapshot is only retaken when the terrain or
+ * the level changes. The scratch level belongs to the worker and is declared
+ * before the scheduler so it outlives the worker thread.
+ */
+struct DistanceResult {
+    Level * level;
+    vector<int> tunneling;
+    vector<int> non_tunneling;
+};
+static shared_ptr<const vector<int> > distance_hardness;
+static unique_ptr<Level> distance_scratch_level;
+static JobScheduler distance_scheduler("distance updates");
+
+/*
+ * The level behind the staircase the player stands on, built ahead of time.
+ * pregeneration_key is what was last asked for; pregenerated_level is a
+ * finished build and the key it was built for.
+ */
+static JobScheduler pregeneration_scheduler("level pregeneration");
+static mutex pregenerated_mutex;
+static Level * pregenerated_level = NULL;
+static LevelKey pregenerated_key;
+static bool pregeneration_requested = false;
+static LevelKey pregeneration_key;
+static mutex distance_result_mutex;
+static DistanceResult distance_result;
+static atomic<bool> distance_result_ready(false);
+static struct Coordinate distance_source;
+static bool terrain_changed = false;
 static int SHOW_HELP = 0;
-static int MAX_ROOM_WIDTH = DEFAULT_MAX_ROOM_WIDTH;
-static int MAX_ROOM_HEIGHT = DEFAULT_MAX_ROOM_HEIGHT;
 
 void add_experience_to_player(int amount);
 void display_magic_status_at_row(int row);
@@ -117,14 +153,23 @@ void make_rlg_directory();
 void make_monster_templates();
 void make_object_templates();
 void generate_new_board();
-void generate_stairs();
-void initialize_board();
-void initialize_immutable_rock();
-void load_board();
+void use_level(Level * new_level);
+void enter_cached_level(Level * cached_level);
+void travel_to_level(LevelKey key);
+LevelKey get_stair_destination(int direction);
+void pregenerate_level_for_stairs();
+Level * take_pregenerated_level(LevelKey key);
+void drop_pregenerated_levels();
+Level * build_level(const atomic<bool> * cancelled = NULL);
+void set_arrival_distances(Level * new_level, const atomic<bool> * cancelled = NULL);
+void populate_level(Level * new_level);
+void load_board(LevelGenerator & generator);
 void save_board();
 void place_player();
 void set_placeable_areas();
+void set_tunneling_distance_to(Level * level, struct Coordinate source, const atomic<bool> * cancelled = NULL);
 void set_tunneling_distance_to_player();
+void set_non_tunneling_distance_to(Level * level, struct Coordinate source, const atomic<bool> * cancelled = NULL);
 void set_non_tunneling_distance_to_player();
 void generate_monsters();
 void print_non_tunneling_board();
@@ -135,24 +180,22 @@ int handle_user_input(int key);
 void handle_user_input_for_look_mode(int key);
 void print_board();
 void print_cell(Board_Cell cell);
-void dig_rooms(int number_of_rooms_to_dig);
-void dig_room();
-int room_is_valid(struct Room room);
-void add_rooms_to_board();
-void dig_cooridors();
-void connect_rooms_at_indexes(int index1, int index2);
 void move_player();
 int get_room_index_player_is_in();
 void move_monster(Monster * monster);
 void print_on_clear_screen(string message);
+void refresh_screen();
+void show_message_log();
 bool cell_is_illuminated(Board_Cell cell);
 bool is_in_line_of_sight(struct Coordinate coord1, struct Coordinate coord2);
-void update_board_distances();
-void update_distances_on_interval();
-int get_number_of_explored_rooms();
+void request_distance_update();
+void compute_distances(Level * target, struct Coordinate source, const vector<int> & hardness, const atomic<bool> & cancelled);
+void apply_distance_results();
 void display_health_status_at(int row);
 void display_stamina_status_at(int row);
 void display_xp_status_at(int row);
+void display_performance_overlay();
+void update_turn_stats();
 int handle_cast_mode_input();
 int cast_spell(Object * spell);
 BoardElement * letPlayerSelectBoardElement();
@@ -164,6 +207,9 @@ int main(int argc, char *args[]) {
     player = new Player();
     struct option longopts[] = { {"save", no_argument, &DO_SAVE, 1},
         {"load", no_argument, &DO_LOAD, 1},
+        {"bsp", no_argument, &USE_BSP, 1},
+        {"events", no_argument, &DO_LOG_EVENTS, 1},
+        {"trace", no_argument, &DO_TRACE, 1},
         {"help", no_argument, &SHOW_HELP, 'h'},
         {0, 0, 0, 0}
     };
@@ -182,6 +228,13 @@ int main(int argc, char *args[]) {
         exit(0);
     }
     make_rlg_directory();
+    if (DO_LOG_EVENTS && !event_log.open(RLG_DIRECTORY + "events.log")) {
+        cout << "Cannot open event log in " << RLG_DIRECTORY << endl;
+    }
+    if (DO_TRACE) {
+        start_tracing();
+        trace_thread_name("main");
+    }
     make_monster_templates();
     make_object_templates();
     generate_new_board();
@@ -192,16 +245,18 @@ int main(int argc, char *args[]) {
     center_board_on_player();
     move(ncurses_player_coord.y, ncurses_player_coord.x);
     refresh();
-    thread t(update_distances_on_interval);
-    t.detach();
     int game_turn = 1;
-    while(monsters.size() > 0 && player->isAlive() && !DO_QUIT) {
+    while(level->monsters.size() > 0 && player->isAlive() && !DO_QUIT) {
+        apply_distance_results();
         center_board_on_player();
-        refresh();
+        refresh_screen();
         Node min = game_queue.extractMin();
         Character * character = min.character;
         int speed;
-        if (character->is(player)) {
+        if (character == player) {
+            PROFILE_SCOPE("player_turn");
+            update_turn_stats();
+            pregenerate_level_for_stairs();
             string message = "It's your turn.";
             if (player->skill_points) {
                 message += " Press ^ to level up.";
@@ -227,32 +282,20 @@ int main(int argc, char *args[]) {
                 break;
             }
             int index = get_room_index_player_is_in();
-            if (index != -1 && !rooms[index].has_explored) {
-                rooms[index].has_explored = true;
+            if (index != -1 && level->exploreRoom(index)) {
                 add_experience_to_player(2);
             }
             center_board_on_player();
-            refresh();
+            refresh_screen();
             if (success == 2) {
                 continue;
             }
-            //update_board_distances();
-
-            /*
-            if (random_int(0, 3) == 0) {
-                thread t(update_board_distances);
-                t.detach();
-            }
-            */
-            /*
-            update_non_tunneling_distance_in_background();
-            update_tunneling_distance_in_background();
-            */
             speed = player->getSpeed();
             player->regenerateStamina(game_turn);
             player->regenerateMagic(game_turn);
         }
         else {
+            PROFILE_SCOPE("monster_turn");
             Monster * monster = (Monster *) character;
             if (monster == NULL) {
                 continue;
@@ -269,15 +312,18 @@ int main(int argc, char *args[]) {
         }
         character->regenerateHealth(game_turn);
         game_turn ++;
+        if (terrain_changed || player->x != distance_source.x || player->y != distance_source.y) {
+            request_distance_update();
+        }
         center_board_on_player();
-        refresh();
+        refresh_screen();
         game_queue.insertWithPriority(character, (1000/speed) + min.priority);
     }
 
     if (!player->isAlive()) {
         add_message("You lost. The monsters killed you (press any key to exit)");
     }
-    else if(!monsters.size()) {
+    else if(!level->monsters.size()) {
         add_message("You won, killing all the monsters (press any key to exit)");
     }
 
@@ -289,9 +335,24 @@ int main(int argc, char *args[]) {
         getch();
     }
     endwin();
+    distance_scheduler.stop();
+    pregeneration_scheduler.stop();
+    drop_pregenerated_levels();
+    event_log.close();
+    cout << profile_report();
+    if (DO_TRACE) {
+        if (!PROFILING_COMPILED_IN) {
+            cout << "--trace records nothing unless built with make PROFILE=1" << endl;
+        }
+        else if (write_trace(RLG_DIRECTORY + "trace.json")) {
+            cout << "Trace written to " << RLG_DIRECTORY << "trace.json" << endl;
+        }
+        else {
+            cout << "Cannot write trace to " << RLG_DIRECTORY << endl;
+        }
+    }
 
-    monsters.clear();
-    objects.clear();
+    level_cache.clear();
     monster_templates.clear();
     object_templates.clear();
 
@@ -306,37 +367,96 @@ void add_experience_to_player(int amount) {
     }
 }
 
-int get_number_of_explored_rooms() {
-    int num = 0;
-    for (int i = 0; i < rooms.size(); i++) {
-        if (rooms[i].has_explored) {
-            num ++;
+/*
+ * Schedules a recomputation of the player's distance maps. A newer request
+ * replaces one that is still waiting; one that is already running finishes
+ * and publishes its maps first.
+ */
+void request_distance_update() {
+    if (!distance_hardness || terrain_changed) {
+        vector<int> * hardness = new vector<int>(HEIGHT * WIDTH);
+        for (int y = 0; y < HEIGHT; y++) {
+            for (int x = 0; x < WIDTH; x++) {
+                (*hardness)[y * WIDTH + x] = board[y][x].hardness;
+            }
         }
+        distance_hardness.reset(hardness);
     }
-    return num;
+    shared_ptr<const vector<int> > hardness = distance_hardness;
+    Level * target = level;
+    struct Coordinate source = player->getCoord();
+    distance_source = source;
+    terrain_changed = false;
+    distance_scheduler.schedule([=](const atomic<bool> & cancelled) {
+        compute_distances(target, source, *hardness, cancelled);
+    });
 }
 
-void update_distances_on_interval() {
-    while(1) {
-        update_board_distances();
-        usleep(1000000);
+/*
+ * Runs on the scheduler's worker. Only the worker touches
+ * distance_scratch_level.
+ */
+void compute_distances(Level * target, struct Coordinate source, const vector<int> & hardness, const atomic<bool> & cancelled) {
+    if (!distance_scratch_level) {
+        distance_scratch_level.reset(new Level());
     }
-}
-void update_board_distances() {
-    set_non_tunneling_distance_to_player();
-    set_tunneling_distance_to_player();
-}
-void update_non_tunneling_distance_in_background() {
-    thread t(set_non_tunneling_distance_to_player);
-    t.detach();
+    Level * scratch_level = distance_scratch_level.get();
+    for (int y = 0; y < HEIGHT; y++) {
+        for (int x = 0; x < WIDTH; x++) {
+            Board_Cell & cell = scratch_level->board[y][x];
+            cell.x = x;
+            cell.y = y;
+            cell.hardness = hardness[y * WIDTH + x];
+        }
+    }
+    set_non_tunneling_distance_to(scratch_level, source, &cancelled);
+    set_tunneling_distance_to(scratch_level, source, &cancelled);
+    if (cancelled) {
+        return;
+    }
+    lock_guard<mutex> lock(distance_result_mutex);
+    distance_result.level = target;
+    distance_result.tunneling.resize(HEIGHT * WIDTH);
+    distance_result.non_tunneling.resize(HEIGHT * WIDTH);
+    for (int y = 0; y < HEIGHT; y++) {
+        for (int x = 0; x < WIDTH; x++) {
+            distance_result.tunneling[y * WIDTH + x] = scratch_level->board[y][x].tunneling_distance;
+            distance_result.non_tunneling[y * WIDTH + x] = scratch_level->board[y][x].non_tunneling_distance;
+        }
+    }
+    distance_result_ready = true;
 }
 
-void update_tunneling_distance_in_background() {
-    thread t(set_tunneling_distance_to_player);
-    t.detach();
+/*
+ * Copies a finished distance job into the board. Called by the game thread
+ * between turns, so monsters never read a map that is being written.
+ */
+void apply_distance_results() {
+    if (!distance_result_ready.load(memory_order_acquire)) {
+        return;
+    }
+    lock_guard<mutex> lock(distance_result_mutex);
+    distance_result_ready = false;
+    if (distance_result.level != level) {
+        return;
+    }
+    for (int y = 0; y < HEIGHT; y++) {
+        for (int x = 0; x < WIDTH; x++) {
+            board[y][x].tunneling_distance = distance_result.tunneling[y * WIDTH + x];
+            board[y][x].non_tunneling_distance = distance_result.non_tunneling[y * WIDTH + x];
+        }
+    }
+    distance_generation ++;
+    distance_updated_ms = chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+}
 
+void set_tunneling_distance_to_player() {
+    set_tunneling_distance_to(level, player->getCoord());
 }
 
+void set_non_tunneling_distance_to_player() {
+    set_non_tunneling_distance_to(level, player->getCoord());
+}
 bool is_in_line_of_sight(struct Coordinate start_coord, struct Coordinate end_coord) {
     /*
      *  This is Bresenham's line algorithm. It can be found here:
@@ -416,11 +536,19 @@ bool damage_monster_from_melee_or_ranged(Monster * monster, Object * weapon, int
 bool damage_monster(Monster * monster, int damage) {
     if (!monster->hitWillConnect()) {
         add_message("You fail to hit the monster!");
+        GameEvent event(EVENT_PLAYER_MISS, level->depth, monster->x, monster->y);
+        event.setName(monster->details->name);
+        event_log.record(event);
         return true;
     }
     monster->damage(damage);
     add_experience_to_player(ceil(damage * 0.1));
     int remaining = monster->hitpoints;
+    GameEvent event(EVENT_PLAYER_HIT, level->depth, monster->x, monster->y);
+    event.amount = damage;
+    event.remaining = max(remaining, 0);
+    event.setName(monster->details->name);
+    event_log.record(event);
     add_message("You deal " + to_string(damage) + " points of damage to the monster (" + to_string(max(remaining, 0)) + " pts remain)");
     bool isAlive = monster->isAlive();
     if (!monster->isAlive()) {
@@ -449,17 +577,11 @@ void init_color_pairs() {
 }
 
 void generate_monsters_from_templates(int how_many) {
-    for (int i = 0; i < monsters.size(); i++) {
-        if (monsters[i]) {
-            delete(monsters[i]);
-        }
-    }
-    monsters.clear();
-    while (monsters.size() < (size_t) how_many) {
+    while (level->monsters.size() < (size_t) how_many) {
         int i = random_int(0, monster_templates.size() - 1);
         struct Coordinate coordinate;
-        MonsterTemplate monster_template = monster_templates[i];
-        Monster * monster = monster_template.makeMonster();
+        MonsterTemplate & monster_template = monster_templates[i];
+        Monster * monster = monster_template.makeMonster(level->monster_pool);
         while (true) {
             coordinate = get_random_board_location();
             Board_Cell cell = board[coordinate.y][coordinate.x];
@@ -473,31 +595,23 @@ void generate_monsters_from_templates(int how_many) {
         monster->x = coordinate.x;
         monster->y = coordinate.y;
         board[monster->y][monster->x].monster = monster;
-        monsters.push_back(monster);
-        game_queue.insertWithPriority(monster, monsters.size());
+        level->addMonster(monster);
+        game_queue.insertWithPriority(monster, level->monsters.size());
     }
 
 }
 
 void generate_objects_from_templates() {
-    for (int i = 0; i < objects.size(); i++) {
-        Object * obj = objects[i];
-        if (obj && !player->hasObject(obj)) {
-            delete(objects[i]);
-        }
-    }
-    objects.clear();
     int number_of_objects = random_int(20, 40);
-    while(objects.size() < (size_t) number_of_objects) {
+    for (int generated = 0; generated < number_of_objects; generated++) {
         int i = random_int(0, object_templates.size() - 1);
         struct Coordinate coordinate;
-        ObjectTemplate object_template = object_templates[i];
-        Object * object = object_template.makeObject();
-        if (player->canPickUpObject() && object->name.compare("Vampirism") == 0) {
-            objects.push_back(object);
-            player->addObjectToInventory(object);
+        ObjectTemplate & object_template = object_templates[i];
+        if (player->canPickUpObject() && object_template.name.compare("Vampirism") == 0) {
+            player->addObjectToInventory(object_template.makeObject());
             continue;
         }
+        Object * object = object_template.makeObject(level->object_pool);
         while(true) {
             coordinate = get_random_board_location();
             Board_Cell cell = board[coordinate.y][coordinate.x];
@@ -508,12 +622,15 @@ void generate_objects_from_templates() {
         object->x = coordinate.x;
         object->y = coordinate.y;
         board[object->y][object->x].object = object;
-        objects.push_back(object);
     }
 }
 
 void make_monster_templates() {
     string filename = RLG_DIRECTORY + "monster_desc.txt";
+    TemplateCache cache = TemplateCache(RLG_DIRECTORY + "monster_desc.cache", filename);
+    if (cache.load(monster_templates)) {
+        return;
+    }
     MonsterDescriptionParser p = MonsterDescriptionParser(filename);
     try {
         p.parseFile();
@@ -523,10 +640,15 @@ void make_monster_templates() {
         exit(1);
     }
     monster_templates = p.getMonsterTemplates();
+    cache.save(monster_templates);
 }
 
 void make_object_templates() {
     string filename = RLG_DIRECTORY + "object_desc.txt";
+    TemplateCache cache = TemplateCache(RLG_DIRECTORY + "object_desc.cache", filename);
+    if (cache.load(object_templates)) {
+        return;
+    }
     ObjectDescriptionParser p = ObjectDescriptionParser(filename);
     try{
         p.parseFile();
@@ -536,54 +658,205 @@ void make_object_templates() {
         exit(2);
     }
     object_templates = p.getObjectTemplates();
+    cache.save(object_templates);
+}
+
+/*
+ * Distance and pregeneration jobs for the level being left are cancelled
+ * first, so none can finish against the new one.
+ */
+void use_level(Level * new_level) {
+    distance_scheduler.cancel();
+    distance_result_ready = false;
+    drop_pregenerated_levels();
+    distance_hardness.reset();
+    distance_source = new_level->player_position;
+    terrain_changed = false;
+    level = new_level;
+    board = level->board;
+    player_board = level->player_board;
+}
+
+void enter_cached_level(Level * cached_level) {
+    use_level(cached_level);
+    game_queue.clear();
+    place_player();
+    for (size_t i = 0; i < level->monsters.size(); i++) {
+        game_queue.insertWithPriority(level->monsters[i], i + 1);
+    }
+    set_placeable_areas();
+    if (level->needs_distance_update) {
+        request_distance_update();
+        level->needs_distance_update = false;
+    }
+}
+
+/*
+ * The level behind the staircase the player is standing on.
+ */
+LevelKey get_stair_destination(int direction) {
+    LevelKey from = level->getKey();
+    int depth = direction == STAIRS_UP ? level->depth - 1 : level->depth + 1;
+    map<LevelKey, LevelKey>::iterator parent = entered_from.find(from);
+    if (parent != entered_from.end() && parent->second.depth == depth) {
+        return parent->second;
+    }
+    pair<LevelKey, int> link(from, player->y * WIDTH + player->x);
+    map<pair<LevelKey, int>, LevelKey>::iterator destination = stair_links.find(link);
+    if (destination != stair_links.end()) {
+        return destination->second;
+    }
+    LevelKey to;
+    to.depth = depth;
+    to.stair = next_stair++;
+    stair_links[link] = to;
+    entered_from[to] = from;
+    return to;
+}
+
+/*
+ * Leaves the current level through a staircase. The level is kept in the
+ * level cache, so coming back later restores it exactly as it was left
+ * instead of generating a new one.
+ */
+void travel_to_level(LevelKey key) {
+    level->player_position = player->getCoord();
+    // The cache may delete the level, so no distance job may still use it
+    distance_scheduler.cancel();
+    distance_result_ready = false;
+    level_cache.store(level);
+    Level * cached_level = level_cache.take(key);
+    if (cached_level) {
+        enter_cached_level(cached_level);
+        return;
+    }
+    populate_level(take_pregenerated_level(key));
+    level->depth = key.depth;
+    level->stair = key.stair;
+}
+
+/*
+ * Starts building the level behind the staircase the player is standing on,
+ * so that taking the stairs only has to swap it in. Levels are built by a
+ * job into their own Level and never touch the current board; a newer
+ * request supersedes an unfinished one.
+ */
+void pregenerate_level_for_stairs() {
+    string type = board[player->y][player->x].type;
+    int direction;
+    if (type.compare(TYPE_UPSTAIR) == 0) {
+        direction = STAIRS_UP;
+    }
+    else if (type.compare(TYPE_DOWNSTAIR) == 0) {
+        direction = STAIRS_DOWN;
+    }
+    else {
+        return;
+    }
+    LevelKey key = get_stair_destination(direction);
+    if (level_cache.contains(key) || (pregeneration_requested && pregeneration_key == key)) {
+        return;
+    }
+    pregeneration_requested = true;
+    pregeneration_key = key;
+    pregeneration_scheduler.schedule([key](const atomic<bool> & cancelled) {
+        Level * new_level = build_level(&cancelled);
+        if (cancelled) {
+            delete new_level;
+            return;
+        }
+        lock_guard<mutex> lock(pregenerated_mutex);
+        delete pregenerated_level;
+        pregenerated_level = new_level;
+        pregenerated_key = key;
+    });
+}
+
+/*
+ * Returns the pregenerated level for the key if it is finished. Otherwise
+ * the level is built right here rather than waiting on the job, which may
+ * not even have started.
+ */
+Level * take_pregenerated_level(LevelKey key) {
+    Level * new_level = NULL;
+    {
+        lock_guard<mutex> lock(pregenerated_mutex);
+        if (pregenerated_level && pregenerated_key == key) {
+            new_level = pregenerated_level;
+            pregenerated_level = NULL;
+        }
+    }
+    drop_pregenerated_levels();
+    if (!new_level) {
+        new_level = build_level();
+    }
+    return new_level;
+}
+
+/*
+ * Cancels pregeneration and forgets any level it finished. The stairs it
+ * was for belong to the level being left.
+ */
+void drop_pregenerated_levels() {
+    pregeneration_scheduler.cancel();
+    pregeneration_requested = false;
+    lock_guard<mutex> lock(pregenerated_mutex);
+    delete pregenerated_level;
+    pregenerated_level = NULL;
+}
+
+/*
+ * Builds the terrain of a new level along with the spot the player arrives
+ * on and both distance maps to it. Only the new level and a generator local
+ * to this call are touched, which makes this safe to run on a worker thread.
+ */
+Level * build_level(const atomic<bool> * cancelled) {
+    PROFILE_SCOPE("build_level");
+    Level * new_level = new Level();
+    LevelGenerator generator;
+    if (USE_BSP) {
+        generator.room_placement = BSP_PLACEMENT;
+    }
+    generator.generate(new_level);
+    set_arrival_distances(new_level, cancelled);
+    return new_level;
+}
+
+void set_arrival_distances(Level * new_level, const atomic<bool> * cancelled) {
+    set_non_tunneling_distance_to(new_level, new_level->player_position, cancelled);
+    set_tunneling_distance_to(new_level, new_level->player_position, cancelled);
 }
 
 void generate_new_board() {
-    initialize_board();
-    rooms.clear();
+    Level * new_level;
     if (DO_LOAD) {
-        load_board();
+        LevelGenerator generator;
+        new_level = new Level();
+        generator.initializeBoard(new_level);
+        use_level(new_level);
+        load_board(generator);
         DO_LOAD = 0;
+        generator.generateStairs(new_level);
+        new_level->player_position = generator.getRandomLocationInRoom(new_level->rooms[0]);
+        set_arrival_distances(new_level);
     }
     else {
-        int num_rooms = random_int(MIN_NUMBER_OF_ROOMS, MAX_NUMBER_OF_ROOMS);
-        dig_rooms(num_rooms);
-        dig_cooridors();
+        new_level = build_level();
     }
+    populate_level(new_level);
+}
 
+void populate_level(Level * new_level) {
+    use_level(new_level);
     game_queue.clear();
     place_player();
     set_placeable_areas();
-    set_non_tunneling_distance_to_player();
-    set_tunneling_distance_to_player();
     int num_monsters = random_int(MIN_NUMBER_OF_MONSTERS, MAX_NUMBER_OF_MONSTERS);
     generate_monsters_from_templates(num_monsters);
-    generate_stairs();
     generate_objects_from_templates();
     int index = get_room_index_player_is_in();
     if (index != -1) {
-        rooms[index].has_explored = true;
-    }
-}
-
-struct Coordinate get_random_unoccupied_location_in_room(struct Room room) {
-    struct Coordinate coord;
-    coord.x = random_int(room.start_x, room.end_x);
-    coord.y = random_int(room.start_y, room.end_y);
-    return coord;
-}
-
-void generate_stairs() {
-    int number_of_stairs_up = rooms.size() / 2;
-    for (int i = 0; i < number_of_stairs_up; i++) {
-        struct Room room = rooms[i];
-        struct Coordinate coord = get_random_unoccupied_location_in_room(room);
-        board[coord.y][coord.x].type = TYPE_UPSTAIR;
-    }
-    for (int i = number_of_stairs_up; i < rooms.size(); i++) {
-        struct Room room = rooms[i];
-        struct Coordinate coord = get_random_unoccupied_location_in_room(room);
-        board[coord.y][coord.x].type = TYPE_DOWNSTAIR;
+        level->exploreRoom(index);
     }
 }
 
@@ -604,33 +877,11 @@ void save_board() {
         cout << "Cannot save file\n";
         return;
     }
-    string file_marker = "RLG327-S2017";
-    uint32_t version = htonl(0);
-    uint32_t file_size = htonl(16820 + (rooms.size() * 4));
-
-    fwrite(file_marker.c_str(), 1, file_marker.length(), fp);
-    fwrite(&version, 1, 4, fp);
-    fwrite(&file_size, 1, 4, fp);
-    for (int y = 0; y < HEIGHT; y++) {
-        for (int x = 0; x < WIDTH; x++) {
-            uint8_t num = board[y][x].hardness;
-            fwrite(&num, 1, 1, fp);
-        }
-    }
-
-    for (size_t i = 0; i < rooms.size(); i++) {
-        struct Room room = rooms[i];
-        uint8_t height = room.end_y - room.start_y + 1;
-        uint8_t width = room.end_x - room.start_x + 1;
-        fwrite(&room.start_x, 1, 1, fp);
-        fwrite(&room.start_y, 1, 1, fp);
-        fwrite(&(width), 1, 1, fp);
-        fwrite(&(height), 1, 1, fp);
-    }
+    level->writeDungeonFile(fp);
     fclose(fp);
 }
 
-void load_board() {
+void load_board(LevelGenerator & generator) {
     string filename = "dungeon";
     string filepath = RLG_DIRECTORY + filename;
     cout << "Loading dungeon: " << filepath << endl;
@@ -700,72 +951,20 @@ void load_board() {
         room.start_y = start_y;
         room.end_x = start_x + width - 1;
         room.end_y = start_y + height - 1;
-        rooms.push_back(room);
+        level->rooms.push_back(room);
         counter ++;
     }
-    add_rooms_to_board();
+    generator.addRoomsToBoard(level);
     fclose(fp);
 }
 
 void print_usage() {
-    printf("usage: generate_dungeon [--save] [--load] [--rooms=<number of rooms>] [--player_x=<player x position>] [--player_y=<player y position>] [--nummon=<number of monsters>]\n");
-}
-
-void initialize_board() {
-    Board_Cell cell;
-    cell.type = TYPE_ROCK;
-    cell.monster = NULL;
-    cell.object = NULL;
-    for (int y = 0; y < HEIGHT; y++) {
-        for (int x = 0; x < WIDTH; x++) {
-            cell.x = x;
-            cell.y = y;
-            cell.hardness = random_int(1, 254);
-            board[y][x] = cell;
-            cell.hardness = IMMUTABLE_ROCK;
-            player_board[y][x] = cell;
-        }
-    }
-    initialize_immutable_rock();
-}
-
-void initialize_immutable_rock() {
-    int y;
-    int x;
-    int max_x = WIDTH - 1;
-    int max_y = HEIGHT - 1;
-    Board_Cell cell;
-    cell.type = TYPE_ROCK;
-    cell.hardness = IMMUTABLE_ROCK;
-    cell.monster = NULL;
-    cell.object = NULL;
-    for (y = 0; y < HEIGHT; y++) {
-        cell.y = y;
-        cell.x = 0;
-        board[y][0] = cell;
-        cell.x = max_x;
-        board[y][max_x] = cell;
-    }
-    for (x = 0; x < WIDTH; x++) {
-        cell.y = 0;
-        cell.x = x;
-        board[0][x] = cell;
-        cell.y = max_y;
-        board[max_y][x] = cell;
-    }
+    printf("usage: generate_dungeon [--save] [--load] [--bsp] [--events] [--trace] [--rooms=<number of rooms>] [--player_x=<player x position>] [--player_y=<player y position>] [--nummon=<number of monsters>]\n");
 }
 
 void place_player() {
-    if (!player->x && !player->y) {
-        struct Room room = rooms[0];
-        int x = random_int(room.start_x, room.end_x);
-        int y = random_int(room.start_y, room.end_y);
-        player->x = x;
-        player->y = y;
-    }
-    struct Coordinate coord;
-    coord.x = player->x;
-    coord.y = player->y;
+    player->x = level->player_position.x;
+    player->y = level->player_position.y;
     game_queue.insertWithPriority(player, 0);
 }
 
@@ -800,7 +999,7 @@ int get_cell_weight(Board_Cell cell) {
     return 1000;
 }
 
-vector<Board_Cell> get_tunneling_neighbors(struct Coordinate coord) {
+vector<Board_Cell> get_tunneling_neighbors(Level * level, struct Coordinate coord) {
     vector<Board_Cell> neighbors;
     int can_go_right = coord.x < WIDTH -1;
     int can_go_up = coord.y > 0;
@@ -808,36 +1007,36 @@ vector<Board_Cell> get_tunneling_neighbors(struct Coordinate coord) {
     int can_go_down = coord.y < HEIGHT -1;
 
     if (can_go_right) {
-        Board_Cell right = board[coord.y][coord.x + 1];
+        Board_Cell right = level->board[coord.y][coord.x + 1];
         if (right.hardness < IMMUTABLE_ROCK) {
             neighbors.push_back(right);
         }
         if (can_go_up) {
-            Board_Cell top_right = board[coord.y - 1][coord.x + 1];
+            Board_Cell top_right = level->board[coord.y - 1][coord.x + 1];
             if (top_right.hardness < IMMUTABLE_ROCK) {
                 neighbors.push_back(top_right);
             }
         }
         if (can_go_down) {
-            Board_Cell bottom_right = board[coord.y + 1][coord.x + 1];
+            Board_Cell bottom_right = level->board[coord.y + 1][coord.x + 1];
             if (bottom_right.hardness < IMMUTABLE_ROCK) {
                 neighbors.push_back(bottom_right);
             }
         }
     }
     if (can_go_left) {
-        Board_Cell left = board[coord.y][coord.x - 1];
+        Board_Cell left = level->board[coord.y][coord.x - 1];
         if (left.hardness < IMMUTABLE_ROCK) {
             neighbors.push_back(left);
         }
         if (can_go_up) {
-            Board_Cell top_left = board[coord.y - 1][coord.x - 1];
+            Board_Cell top_left = level->board[coord.y - 1][coord.x - 1];
             if (top_left.hardness < IMMUTABLE_ROCK) {
                 neighbors.push_back(top_left);
             }
         }
         if (can_go_down) {
-            Board_Cell bottom_left = board[coord.y + 1][coord.x - 1];
+            Board_Cell bottom_left = level->board[coord.y + 1][coord.x - 1];
             if (bottom_left.hardness < IMMUTABLE_ROCK) {
                 neighbors.push_back(bottom_left);
             }
@@ -845,13 +1044,13 @@ vector<Board_Cell> get_tunneling_neighbors(struct Coordinate coord) {
     }
 
     if (can_go_up) {
-        Board_Cell above = board[coord.y - 1][coord.x];
+        Board_Cell above = level->board[coord.y - 1][coord.x];
         if (above.hardness < IMMUTABLE_ROCK) {
             neighbors.push_back(above);
         }
     }
     if (can_go_down) {
-        Board_Cell below = board[coord.y + 1][coord.x];
+        Board_Cell below = level->board[coord.y + 1][coord.x];
         if (below.hardness < IMMUTABLE_ROCK) {
             neighbors.push_back(below);
         }
@@ -861,38 +1060,42 @@ vector<Board_Cell> get_tunneling_neighbors(struct Coordinate coord) {
 }
 
 
-void set_tunneling_distance_to_player() {
+void set_tunneling_distance_to(Level * level, struct Coordinate source, const atomic<bool> * cancelled) {
+    PROFILE_SCOPE("tunneling_distance");
     PriorityQueue tunneling_queue = PriorityQueue();
     for (int y = 0; y < HEIGHT; y++) {
         for (int x = 0; x < WIDTH; x++) {
             struct Coordinate coord;
             coord.x = x;
             coord.y = y;
-            if (y == player->y && x == player->x) {
-                board[y][x].tunneling_distance = 0;
+            if (y == source.y && x == source.x) {
+                level->board[y][x].tunneling_distance = 0;
             }
             else {
-                board[y][x].tunneling_distance = INT_MAX;
+                level->board[y][x].tunneling_distance = INT_MAX;
             }
-            if (board[y][x].hardness < IMMUTABLE_ROCK) {
-                tunneling_queue.insertCoordWithPriority(coord, board[y][x].tunneling_distance);
+            if (level->board[y][x].hardness < IMMUTABLE_ROCK) {
+                tunneling_queue.insertCoordWithPriority(coord, level->board[y][x].tunneling_distance);
             }
         }
     }
     int count = 0;
     while(tunneling_queue.size()) {
+        if (cancelled && *cancelled) {
+            return;
+        }
         Node min = tunneling_queue.extractMin();
-        Board_Cell min_cell = board[min.coord.y][min.coord.x];
-        vector<Board_Cell> neighbors = get_tunneling_neighbors(min.coord);
+        Board_Cell min_cell = level->board[min.coord.y][min.coord.x];
+        vector<Board_Cell> neighbors = get_tunneling_neighbors(level, min.coord);
         int min_dist = min_cell.tunneling_distance + get_cell_weight(min_cell);
         for (size_t i = 0; i < neighbors.size(); i++) {
             Board_Cell neighbor_cell = neighbors[i];
-            Board_Cell cell = board[neighbor_cell.y][neighbor_cell.x];
+            Board_Cell cell = level->board[neighbor_cell.y][neighbor_cell.x];
             if (min_dist < cell.tunneling_distance) {
                 struct Coordinate coord;
                 coord.x = cell.x;
                 coord.y = cell.y;
-                board[cell.y][cell.x].tunneling_distance = min_dist;
+                level->board[cell.y][cell.x].tunneling_distance = min_dist;
                 tunneling_queue.decreaseCoordPriority(coord, min_dist);
             }
         }
@@ -901,25 +1104,25 @@ void set_tunneling_distance_to_player() {
     }
 };
 
-vector<Board_Cell> get_non_tunneling_neighbors(struct Coordinate coord) {
+vector<Board_Cell> get_non_tunneling_neighbors(Level * level, struct Coordinate coord) {
     vector<Board_Cell> neighbors;
     int can_go_right = coord.x < WIDTH -1;
     int can_go_up = coord.y > 0;
     int can_go_left = coord.x > 0;
     int can_go_down = coord.y < HEIGHT -1;
     if (can_go_right) {
-        Board_Cell right = board[coord.y][coord.x + 1];
+        Board_Cell right = level->board[coord.y][coord.x + 1];
         if (right.hardness < 1) {
             neighbors.push_back(right);
         }
         if (can_go_up) {
-            Board_Cell top_right = board[coord.y - 1][coord.x + 1];
+            Board_Cell top_right = level->board[coord.y - 1][coord.x + 1];
             if (top_right.hardness < 1) {
                 neighbors.push_back(top_right);
             }
         }
         if (can_go_down) {
-            Board_Cell bottom_right = board[coord.y + 1][coord.x + 1];
+            Board_Cell bottom_right = level->board[coord.y + 1][coord.x + 1];
             if (bottom_right.hardness < 1) {
                 neighbors.push_back(bottom_right);
             }
@@ -927,18 +1130,18 @@ vector<Board_Cell> get_non_tunneling_neighbors(struct Coordinate coord) {
     }
 
     if (can_go_left) {
-        Board_Cell left = board[coord.y][coord.x - 1];
+        Board_Cell left = level->board[coord.y][coord.x - 1];
         if (left.hardness < 1) {
             neighbors.push_back(left);
         }
         if (can_go_up) {
-            Board_Cell top_left = board[coord.y - 1][coord.x - 1];
+            Board_Cell top_left = level->board[coord.y - 1][coord.x - 1];
             if (top_left.hardness < 1) {
                 neighbors.push_back(top_left);
             }
         }
         if (can_go_down) {
-            Board_Cell bottom_left = board[coord.y + 1][coord.x - 1];
+            Board_Cell bottom_left = level->board[coord.y + 1][coord.x - 1];
             if (bottom_left.hardness < 1) {
                 neighbors.push_back(bottom_left);
             }
@@ -946,13 +1149,13 @@ vector<Board_Cell> get_non_tunneling_neighbors(struct Coordinate coord) {
     }
 
     if (can_go_up) {
-        Board_Cell above = board[coord.y - 1][coord.x];
+        Board_Cell above = level->board[coord.y - 1][coord.x];
         if (above.hardness < 1) {
             neighbors.push_back(above);
         }
     }
     if (can_go_down) {
-        Board_Cell below = board[coord.y + 1][coord.x];
+        Board_Cell below = level->board[coord.y + 1][coord.x];
         if (below.hardness < 1) {
             neighbors.push_back(below);
         }
@@ -960,37 +1163,41 @@ vector<Board_Cell> get_non_tunneling_neighbors(struct Coordinate coord) {
     return neighbors;
 }
 
-void set_non_tunneling_distance_to_player() {
+void set_non_tunneling_distance_to(Level * level, struct Coordinate source, const atomic<bool> * cancelled) {
+    PROFILE_SCOPE("non_tunneling_distance");
     PriorityQueue non_tunneling_queue = PriorityQueue();
     for (int y = 0; y < HEIGHT; y++) {
         for (int x = 0; x < WIDTH; x++) {
             struct Coordinate coord;
             coord.x = x;
             coord.y = y;
-            if (y == player->y && x == player->x) {
-                board[y][x].non_tunneling_distance = 0;
+            if (y == source.y && x == source.x) {
+                level->board[y][x].non_tunneling_distance = 0;
             }
             else {
-                board[y][x].non_tunneling_distance = INT_MAX;
+                level->board[y][x].non_tunneling_distance = INT_MAX;
             }
-            if (board[y][x].hardness < 1) {
-                non_tunneling_queue.insertCoordWithPriority(coord, board[y][x].non_tunneling_distance);
+            if (level->board[y][x].hardness < 1) {
+                non_tunneling_queue.insertCoordWithPriority(coord, level->board[y][x].non_tunneling_distance);
             }
         }
     }
     while(non_tunneling_queue.size()) {
+        if (cancelled && *cancelled) {
+            return;
+        }
         Node min = non_tunneling_queue.extractMin();
-        Board_Cell min_cell = board[min.coord.y][min.coord.x];
-        vector<Board_Cell> neighbors = get_non_tunneling_neighbors(min.coord);
+        Board_Cell min_cell = level->board[min.coord.y][min.coord.x];
+        vector<Board_Cell> neighbors = get_non_tunneling_neighbors(level, min.coord);
         int min_dist = min_cell.non_tunneling_distance + 1;
         for (size_t i = 0; i < neighbors.size(); i++) {
             Board_Cell neighbor_cell = neighbors[i];
-            Board_Cell cell = board[neighbor_cell.y][neighbor_cell.x];
+            Board_Cell cell = level->board[neighbor_cell.y][neighbor_cell.x];
             if (min_dist < cell.non_tunneling_distance) {
                 struct Coordinate coord;
                 coord.x = cell.x;
                 coord.y = cell.y;
-                board[cell.y][cell.x].non_tunneling_distance = min_dist;
+                level->board[cell.y][cell.x].non_tunneling_distance = min_dist;
                 non_tunneling_queue.decreaseCoordPriority(coord, min_dist);
             }
         }
@@ -1045,10 +1252,7 @@ void print_tunneling_board() {
 
 void add_message(string message) {
     add_temp_message(message);
-    Message * my_message = new Message(message);
-    if (all_messages.size() == 0 || all_messages[0]->message.compare(message)) {
-        all_messages.insert(all_messages.begin(), my_message);
-    }
+    message_log.add(message);
 }
 
 void add_temp_message(string message) {
@@ -1059,6 +1263,14 @@ void add_temp_message(string message) {
     refresh();
 }
 
+/*
+ * refresh() for the turn loop, timed separately from the board updates.
+ */
+void refresh_screen() {
+    PROFILE_SCOPE("refresh");
+    refresh();
+}
+
 void print_on_clear_screen(string message) {
     curs_set(0);
     clear();
@@ -1069,7 +1281,42 @@ void print_on_clear_screen(string message) {
     add_temp_message("It's your turn");
 }
 
+/*
+ * Pages through the message log one screen at a time, newest first.
+ */
+void show_message_log() {
+    curs_set(0);
+    int page_size = max(LINES - 5, 1);
+    size_t first = 0;
+    while (true) {
+        clear();
+        mvprintw(0, 0, "MESSAGES (%zu-%zu of %zu)", message_log.size() ? first + 1 : 0,
+                 min(first + page_size, message_log.size()), message_log.size());
+        for (int i = 0; i < page_size && first + i < message_log.size(); i++) {
+            mvprintw(i + 2, 0, "%s", message_log.toString(first + i).c_str());
+        }
+        mvprintw(page_size + 3, 0, "(j: older, k: newer, any other key: return to game view)");
+        refresh();
+        int key = getch();
+        if (key == 106) { // j - older page
+            if (first + page_size < message_log.size()) {
+                first += page_size;
+            }
+        }
+        else if (key == 107) { // k - newer page
+            first = first > (size_t) page_size ? first - page_size : 0;
+        }
+        else {
+            break;
+        }
+    }
+    clear();
+    center_board_on_player();
+    add_temp_message("It's your turn");
+}
+
 void update_player_board() {
+    PROFILE_SCOPE("update_player_board");
     struct Coordinate p_coord;
     p_coord.x = player->x;
     p_coord.y = player->y;
@@ -1112,6 +1359,7 @@ bool cell_is_illuminated(Board_Cell cell) {
 
 
 void update_board_view(int ncurses_start_x, int ncurses_start_y) {
+    PROFILE_SCOPE("update_board_view");
     update_player_board();
     ncurses_start_x = min(ncurses_start_x + NCURSES_WIDTH, WIDTH - 1);
     ncurses_start_y = min(ncurses_start_y + NCURSES_HEIGHT, HEIGHT - 1);
@@ -1135,9 +1383,9 @@ void update_board_view(int ncurses_start_x, int ncurses_start_y) {
             }
             else if (player_board[y][x].monster) {
                 Monster *monster = player_board[y][x].monster;
-                int color_key = color_map[monster->color];
+                int color_key = color_map[monster->details->color];
                 attron(COLOR_PAIR(color_key));
-                mvprintw(row, col, "%c", monster->symbol);
+                mvprintw(row, col, "%c", monster->details->symbol);
                 attroff(COLOR_PAIR(color_key));
             }
             else if(player_board[y][x].object) {
@@ -1201,12 +1449,62 @@ void update_board_view(int ncurses_start_x, int ncurses_start_y) {
 
     move(row, 0);
     clrtoeol();
-    mvprintw(row, 0, ("Monsters remaining: " + to_string(monsters.size())).c_str());
+    mvprintw(row, 0, hud.getMonstersLine(level->monsters.size()).c_str());
     row++;
     move(row, 0);
     clrtoeol();
-    mvprintw(row, 0, ("Rooms explored: " + to_string(get_number_of_explored_rooms()) + "/" + to_string(rooms.size())).c_str());
+    mvprintw(row, 0, hud.getRoomsLine(level->number_of_explored_rooms, level->rooms.size()).c_str());
     row++;
+    if (SHOW_OVERLAY) {
+        display_performance_overlay();
+    }
+}
+
+void update_turn_stats() {
+    if (!PROFILING_COMPILED_IN) {
+        return;
+    }
+    static ProfileSection & monster_section = profile_section("move_monster");
+    uint64_t monster_ns = monster_section.getTotal();
+    uint64_t allocations = thread_allocations();
+    turn_stats.monster_ns = monster_ns - turn_stats.monster_ns_mark;
+    turn_stats.allocations = allocations - turn_stats.allocations_mark;
+    turn_stats.monster_ns_mark = monster_ns;
+    turn_stats.allocations_mark = allocations;
+}
+
+/*
+ * Drawn over the top right corner of the board. Timings and allocation
+ * counts come from the profiler and need a make PROFILE=1 build. Nothing
+ * here allocates, so the overlay does not show up in its own counts.
+ */
+void display_performance_overlay() {
+    char lines[6][OVERLAY_WIDTH + 1];
+    int count = 0;
+    if (PROFILING_COMPILED_IN) {
+        static ProfileSection & frame_section = profile_section("update_board_view");
+        snprintf(lines[count++], OVERLAY_WIDTH + 1, "frame        %8.2f ms", frame_section.getLast() / 1000000.0);
+        snprintf(lines[count++], OVERLAY_WIDTH + 1, "monster turn %8.2f ms", turn_stats.monster_ns / 1000000.0);
+        snprintf(lines[count++], OVERLAY_WIDTH + 1, "allocations  %8llu /turn", (unsigned long long) turn_stats.allocations);
+    }
+    else {
+        snprintf(lines[count++], OVERLAY_WIDTH + 1, "timings need make PROFILE=1");
+    }
+    int64_t now_ms = chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+    if (distance_generation) {
+        snprintf(lines[count++], OVERLAY_WIDTH + 1, "distances    #%u, %.1fs old", distance_generation, (now_ms - distance_updated_ms) / 1000.0);
+    }
+    else {
+        snprintf(lines[count++], OVERLAY_WIDTH + 1, "distances    not updated yet");
+    }
+    snprintf(lines[count++], OVERLAY_WIDTH + 1, "monsters %4zu  objects %4zu", level->monster_pool.size(), level->object_pool.size());
+    snprintf(lines[count++], OVERLAY_WIDTH + 1, "turn queue   %4d", game_queue.size());
+    int col = NCURSES_WIDTH + 1 - OVERLAY_WIDTH;
+    attron(A_REVERSE);
+    for (int i = 0; i < count; i++) {
+        mvprintw(i + 1, col, "%-*s", OVERLAY_WIDTH, lines[i]);
+    }
+    attroff(A_REVERSE);
 }
 
 void display_health_status_at(int row) {
@@ -1216,7 +1514,7 @@ void display_health_status_at(int row) {
     move(row, 0);
     clrtoeol();
     attron(COLOR_PAIR(red));
-    mvprintw(row, 0, (player->getStatusProgressBar(player->hitpoints/(1.0*player->max_hitpoints)).c_str()));
+    mvprintw(row, 0, hud.getBar(HEALTH_BAR, player->hitpoints/(1.0*player->max_hitpoints)).c_str());
     attroff(COLOR_PAIR(red));
 }
 
@@ -1227,7 +1525,7 @@ void display_stamina_status_at(int row) {
     clrtoeol();
     int green = color_map["GREEN"];
     attron(COLOR_PAIR(green));
-    mvprintw(row, 0, (player->getStatusProgressBar(player->stamina_points/(1.0*player->max_stamina_points))).c_str());
+    mvprintw(row, 0, hud.getBar(STAMINA_BAR, player->stamina_points/(1.0*player->max_stamina_points)).c_str());
     attroff(COLOR_PAIR(green));
 }
 
@@ -1238,7 +1536,7 @@ void display_magic_status_at_row(int row) {
     clrtoeol();
     int blue = color_map["BLUE"];
     attron(COLOR_PAIR(blue));
-    mvprintw(row, 0, (player->getStatusProgressBar(player->magic/(1.0*player->max_magic))).c_str());
+    mvprintw(row, 0, hud.getBar(MAGIC_BAR, player->magic/(1.0*player->max_magic)).c_str());
     attroff(COLOR_PAIR(blue));
 }
 
@@ -1253,7 +1551,7 @@ void display_xp_status_at(int row) {
     if (player->skill_points) {
         percentage = 1;
     }
-    mvprintw(row, 0, (player->getStatusProgressBar(percentage)).c_str());
+    mvprintw(row, 0, hud.getBar(XP_BAR, percentage).c_str());
     attroff(COLOR_PAIR(yellow));
 }
 
@@ -1286,22 +1584,14 @@ void handle_user_input_for_look_mode(int key) {
 }
 
 void handle_killed_monster(Monster * monster) {
+    GameEvent event(EVENT_MONSTER_KILLED, level->depth, monster->x, monster->y);
+    event.amount = monster->experience;
+    event.setName(monster->details->name);
+    event_log.record(event);
     add_experience_to_player(monster->experience);
     game_queue.removeFromQueue(monster);
     board[monster->y][monster->x].monster = NULL;
-    int index = -1;
-    for (size_t i = 0; i < monsters.size(); i++) {
-        if (!monsters[i]->id.compare(monster->id)) {
-            index = i;
-            break;
-        }
-    }
-    if (index >= 0) {
-        monsters.erase(monsters.begin() + index);
-    }
-    if (monster) {
-        delete(monster);
-    }
+    level->removeMonster(monster);
 
 }
 
@@ -1430,8 +1720,8 @@ int cast_spell(Object * spell) {
         add_message("You teleport to a room");
         int index = get_room_index_player_is_in();
         int new_room_index = -1;
-        for (int i = 0; i < rooms.size(); i++) {
-            struct Room room = rooms[i];
+        for (int i = 0; i < level->rooms.size(); i++) {
+            struct Room room = level->rooms[i];
             if (room.has_explored && index != i) {
                 new_room_index = i;
                 break;
@@ -1441,7 +1731,7 @@ int cast_spell(Object * spell) {
             add_message("There is no available room to teleport to");
             return 0;
         }
-        struct Room new_room = rooms[new_room_index];
+        struct Room new_room = level->rooms[new_room_index];
         int x = random_int(new_room.start_x, new_room.end_x);
         int y = random_int(new_room.start_y, new_room.end_y);
         while (board[y][x].monster || board[y][x].object) {
@@ -1490,11 +1780,7 @@ int handle_ranged_mode_input() {
     if (!m) {
         return handle_ranged_mode_input();
     }
-    vector<int> indexes = player->getIndexOfEquipmentType("RANGED");
-    Object * weapon = NULL;
-    if (indexes.size() > 0) {
-        weapon = player->getEquipmentAt(indexes[0]);
-    }
+    Object * weapon = player->getEquipmentAt(SLOT_RANGED);
     int damage = player->getRangedAttackDamage();
     if (weapon && !player->hasEnoughStaminaForAttack(weapon->cost)) {
         add_message("You do not have enough stamina for this attack!");
@@ -1643,6 +1929,8 @@ int handle_user_input(int key) {
         message += "n - one cell bottom-right\n\n";
         message += "GENERAL OPERATIONS\n";
         message += "M - show messages\n";
+        message += "P - show turn timings (make PROFILE=1)\n";
+        message += "O - toggle performance overlay\n";
         message += "L - enter look mode\n";
         message += "r - enter ranged mode\n";
         message += "H - view HUD\n";
@@ -1658,6 +1946,19 @@ int handle_user_input(int key) {
         print_on_clear_screen(message);
         return 0;
     }
+    else if (key == 80) { // P - show profile
+        string report = profile_report();
+        if (!report.size()) {
+            report = "Timers are not compiled in. Build with make PROFILE=1 to record them.\n";
+        }
+        print_on_clear_screen("PROFILE\n\n" + report + "\n(Press any key to return to game view)");
+        return 0;
+    }
+    else if (key == 79) { // O - toggle performance overlay
+        SHOW_OVERLAY = !SHOW_OVERLAY;
+        center_board_on_player();
+        return 0;
+    }
     else if (key == 94) { // ^ - level up
         show_level_up_screen();
         return 0;
@@ -1673,14 +1974,7 @@ int handle_user_input(int key) {
         print_on_clear_screen(message);
     }
     else if (key == 77) { // M - show messages
-        string logs = "";
-        for(int i = 0; i < all_messages.size(); i++) {
-            logs += all_messages[i]->toString() + "\n";
-        }
-        string message = "MESSAGES\n\n";
-        message += logs + "\n\n";
-        message += "(Press any key to return to game view)";
-        print_on_clear_screen(message);
+        show_message_log();
         return 0;
     }
     else if (key == 120) { // x - expunge
@@ -1735,9 +2029,12 @@ int handle_user_input(int key) {
             return 0;
         }
         Object * object = player->getInventoryItemAt(index);
+        player->removeInventoryItemAt(index);
+        object = level->adoptObject(object);
+        object->x = player->x;
+        object->y = player->y;
         board[player->y][player->x].object = object;
         player_board[player->y][player->x].object = object;
-        player->removeInventoryItemAt(index);
         add_message("Dropped " + object->name + ". It's your turn");
         return 0;
     }
@@ -1914,10 +2211,12 @@ int handle_user_input(int key) {
            return 0;
         }
         add_message("You travel upstairs");
-        player->x = 0;
-        player->y = 0;
+        LevelKey destination = get_stair_destination(STAIRS_UP);
+        GameEvent event(EVENT_STAIRS, level->depth, player->x, player->y);
+        event.amount = destination.depth;
+        event_log.record(event);
         player->addExperience(Numeric("0+5d3").roll());
-        generate_new_board();
+        travel_to_level(destination);
         return 2;
     }
     else if (key == 62) {  // downstairs
@@ -1925,10 +2224,12 @@ int handle_user_input(int key) {
             return 0;
         }
         add_message("You travel downstairs");
-        player->y = 0;
-        player->x = 0;
+        LevelKey destination = get_stair_destination(STAIRS_DOWN);
+        GameEvent event(EVENT_STAIRS, level->depth, player->x, player->y);
+        event.amount = destination.depth;
+        event_log.record(event);
         player->addExperience(Numeric("0+5d3").roll());
-        generate_new_board();
+        travel_to_level(destination);
         return 2;
     }
     else if (key == 32 || key == 5) { // space - rest
@@ -1947,11 +2248,7 @@ int handle_user_input(int key) {
     if (board[new_coord.y][new_coord.x].monster) {
         Monster * monster = board[new_coord.y][new_coord.x].monster;
         int damage = player->getAttackDamage();
-        vector<int> indexes = player->getIndexOfEquipmentType("WEAPON");
-        Object * weapon = NULL;
-        if (indexes.size() > 0) {
-            weapon = player->getEquipmentAt(indexes[0]);
-        }
+        Object * weapon = player->getEquipmentAt(SLOT_WEAPON);
         int cost = 3;
         if (weapon) {
             cost = weapon->cost;
@@ -1978,8 +2275,12 @@ int handle_user_input(int key) {
     Board_Cell cell = board[new_coord.y][new_coord.x];
     if (cell.object && player->canPickUpObject()) {
         add_message("You picked up an object: " + cell.object->name);
-        player->addObjectToInventory(cell.object);
+        GameEvent event(EVENT_PICKUP, level->depth, new_coord.x, new_coord.y);
+        event.setName(cell.object->name);
+        event_log.record(event);
+        player->addObjectToInventory(level->releaseObject(cell.object));
         board[new_coord.y][new_coord.x].object = NULL;
+        player_board[new_coord.y][new_coord.x].object = NULL;
     }
     update_player_board();
     return 1;
@@ -2004,7 +2305,7 @@ void print_board() {
                 coord.x = x;
                 coord.y = y;
                 Monster * m = board[y][x].monster;
-                int decimal_type = m->symbol;
+                int decimal_type = m->details->symbol;
                 printf("%x", decimal_type);
             }
             else {
@@ -2030,159 +2331,6 @@ void print_cell(Board_Cell cell) {
     }
 }
 
-void dig_rooms(int number_of_rooms_to_dig) {
-    for (int i = 0; i < number_of_rooms_to_dig; i++) {
-        dig_room();
-    }
-    add_rooms_to_board();
-}
-
-void dig_room() {
-    int start_x = random_int(1, WIDTH - MIN_ROOM_WIDTH - 1);
-    int start_y = random_int(1, HEIGHT - MIN_ROOM_HEIGHT - 1);
-    int room_height = random_int(MIN_ROOM_HEIGHT, MAX_ROOM_HEIGHT);
-    int room_width = random_int(MIN_ROOM_WIDTH, MAX_ROOM_WIDTH);
-    int end_y = start_y + room_height;
-    if (end_y >= HEIGHT - 1) {
-        end_y = HEIGHT - 2;
-
-    }
-    int end_x = start_x + room_width;
-    if (end_x >= WIDTH - 1) {
-        end_x = WIDTH - 2;
-
-    }
-    int height = end_y - start_y;
-    int height_diff = MIN_ROOM_HEIGHT - height;
-    if (height_diff > 0) {
-        start_y -= height_diff + 1;
-    }
-
-    int width = end_x - start_x;
-    int width_diff = MIN_ROOM_WIDTH - width;
-    if (width_diff > 0) {
-        start_x -= width_diff + 1;
-    }
-    struct Room room;
-    room.start_x = start_x;
-    room.start_y = start_y;
-    room.end_x = end_x;
-    room.end_y = end_y;
-    room.has_explored = false;
-    if (room_is_valid(room)) {
-        rooms.push_back(room);
-    }
-    else {
-        dig_room();
-    }
-}
-
-int room_is_valid(struct Room room) {
-    int width = room.end_x - room.start_x;
-    int height = room.end_y - room.start_y;
-    if (height < MIN_ROOM_HEIGHT || width < MIN_ROOM_WIDTH) {
-        return 0;
-    }
-    if (room.start_x < 1 || room.start_y < 1 || room.end_x > WIDTH - 2 || room.end_y > HEIGHT - 2) {
-        return 0;
-    }
-    for (size_t i = 0; i < rooms.size(); i++) {
-        struct Room current_room = rooms[i];
-        int start_x = current_room.start_x - 1;
-        int start_y = current_room.start_y - 1;
-        int end_x = current_room.end_x + 1;
-        int end_y = current_room.end_y + 1;
-        if ((room.start_x >= start_x  && room.start_x <= end_x) ||
-                (room.end_x >= start_x && room.end_x <= end_x)) {
-            if ((room.start_y >= start_y && room.start_y <= end_y) ||
-                    (room.end_y >= start_y && room.end_y <= end_y)) {
-                return 0;
-            }
-        }
-    }
-    return 1;
-}
-
-void add_rooms_to_board() {
-    Board_Cell cell;
-    cell.type = TYPE_ROOM;
-    cell.hardness = ROOM;
-    cell.monster = NULL;
-    cell.object = NULL;
-    for(size_t i = 0; i < rooms.size(); i++) {
-        struct Room room = rooms[i];
-        for (int y = room.start_y; y <= room.end_y; y++) {
-            for(int x = room.start_x; x <= room.end_x; x++) {
-                cell.x = x;
-                cell.y = y;
-                board[y][x] = cell;
-            }
-        }
-    }
-}
-
-void dig_cooridors() {
-    for (size_t i = 0; i < rooms.size(); i++) {
-        int next_index = i + 1;
-        if ((size_t) next_index == rooms.size()) {
-            next_index = 0;
-        }
-        connect_rooms_at_indexes(i, next_index);
-    }
-}
-
-void connect_rooms_at_indexes(int index1, int index2) {
-    struct Room room1 = rooms[index1];
-    struct Room room2 = rooms[index2];
-    int start_x = ((room1.end_x - room1.start_x) / 2) + room1.start_x;
-    int end_x = ((room2.end_x - room2.start_x) / 2) + room2.start_x;
-    int start_y = ((room1.end_y - room1.start_y) / 2) + room1.start_y;
-    int end_y = ((room2.end_y - room2.start_y) / 2) + room2.start_y;
-    int x_incrementer = 1;
-    int y_incrementer = 1;
-    if (start_x > end_x) {
-        x_incrementer = -1;
-    }
-    if (start_y > end_y) {
-        y_incrementer = -1;
-    }
-    int cur_x = start_x;
-    int cur_y = start_y;
-    while(1) {
-        int random_num = random_int(0, RAND_MAX);
-        int move_y = random_num % 2 == 0;
-        if (board[cur_y][cur_x].type.compare(TYPE_ROCK) != 0) {
-            if (cur_y != end_y) {
-                cur_y += y_incrementer;
-            }
-            else if(cur_x != end_x) {
-                cur_x += x_incrementer;
-            }
-            else if(cur_y == end_y && cur_x == end_x) {
-                break;
-            }
-            continue;
-        }
-        Board_Cell corridor_cell;
-        corridor_cell.type = TYPE_CORRIDOR;
-        corridor_cell.hardness = CORRIDOR;
-        corridor_cell.monster = NULL;
-        corridor_cell.object = NULL;
-        corridor_cell.x = cur_x;
-        corridor_cell.y = cur_y;
-        board[cur_y][cur_x] = corridor_cell;
-        if ((cur_y != end_y && move_y) || (cur_x == end_x)) {
-            cur_y += y_incrementer;
-        }
-        else if ((cur_x != end_x && !move_y) || (cur_y == end_y)) {
-            cur_x += x_incrementer;
-        }
-        else {
-            break;
-        }
-    }
-}
-
 vector<struct Coordinate> get_non_tunneling_available_coords_for(struct Coordinate coord) {
     int x = coord.x;
     int y = coord.y;
@@ -2316,17 +2464,7 @@ Board_Cell get_cell_on_non_tunneling_path(struct Coordinate c) {
 }
 
 int get_room_index_player_is_in() {
-    int index = -1;
-    for (size_t i = 0; i < rooms.size(); i++) {
-        struct Room current_room = rooms[i];
-        if (current_room.start_x <= player->x && player->x <= current_room.end_x) {
-            if (current_room.start_y <= player->y && player->y <= current_room.end_y) {
-                index = i;
-                break;
-            }
-        }
-    }
-    return index;
+    return level->getRoomIndexAt(player->x, player->y);
 }
 
 int should_do_erratic_behavior() {
@@ -2390,6 +2528,7 @@ void displace_monster(struct Coordinate coord) {
 }
 
 void move_monster(Monster * monster) {
+    PROFILE_SCOPE("move_monster");
     int monster_x = monster->x;
     int monster_y = monster->y;
     Board_Cell cell = board[monster_y][monster_x];
@@ -2399,7 +2538,7 @@ void move_monster(Monster * monster) {
     struct Coordinate new_coord;
     new_coord.x = monster_x;
     new_coord.y = monster_y;
-    int decimal_type = monster->getDecimalType();
+    int decimal_type = monster->decimal_type;
     struct Coordinate last_known_player_location;
     last_known_player_location.x = monster->last_known_player_x;
     last_known_player_location.y = monster->last_known_player_y;
@@ -2453,6 +2592,7 @@ void move_monster(Monster * monster) {
             cell = board[new_coord.y][new_coord.x];
             if (cell.hardness > 0) {
                 board[cell.y][cell.x].hardness -= 85;
+                terrain_changed = true;
                 if (board[cell.y][cell.x].hardness <= 0) {
                     board[cell.y][cell.x].hardness = 0;
                     board[cell.y][cell.x].type = TYPE_CORRIDOR;
@@ -2480,6 +2620,7 @@ void move_monster(Monster * monster) {
                 cell = board[new_coord.y][new_coord.x];
                 if (cell.hardness > 0) {
                     board[cell.y][cell.x].hardness -= 85;
+                    terrain_changed = true;
                     if (board[cell.y][cell.x].hardness <= 0) {
                         board[cell.y][cell.x].hardness = 0;
                         board[cell.y][cell.x].type = TYPE_CORRIDOR;
@@ -2496,6 +2637,7 @@ void move_monster(Monster * monster) {
             cell = board[new_coord.y][new_coord.x];
             if (cell.hardness > 0) {
                 board[cell.y][cell.x].hardness -= 85;
+                terrain_changed = true;
                 if (board[cell.y][cell.x].hardness <= 0) {
                     board[cell.y][cell.x].hardness = 0;
                     board[cell.y][cell.x].type = TYPE_CORRIDOR;
@@ -2512,6 +2654,7 @@ void move_monster(Monster * monster) {
             new_coord.y = cell.y;
             if (cell.hardness > 0) {
                 board[cell.y][cell.x].hardness -= 85;
+                terrain_changed = true;
                 if (board[cell.y][cell.x].hardness <= 0) {
                     board[cell.y][cell.x].hardness = 0;
                     board[cell.y][cell.x].type = TYPE_CORRIDOR;
@@ -2577,6 +2720,7 @@ void move_monster(Monster * monster) {
                 cell = board[new_coord.y][new_coord.x];
                 if (cell.hardness > 0) {
                     board[cell.y][cell.x].hardness -= 85;
+                    terrain_changed = true;
                     if (board[cell.y][cell.x].hardness <= 0) {
                         board[cell.y][cell.x].hardness = 0;
                         board[cell.y][cell.x].type = TYPE_CORRIDOR;
@@ -2602,6 +2746,7 @@ void move_monster(Monster * monster) {
                 cell = board[new_coord.y][new_coord.x];
                 if (cell.hardness > 0) {
                     board[cell.y][cell.x].hardness -= 85;
+                    terrain_changed = true;
                     if (board[cell.y][cell.x].hardness <= 0) {
                         board[cell.y][cell.x].hardness = 0;
                         board[cell.y][cell.x].type = TYPE_CORRIDOR;
@@ -2634,6 +2779,7 @@ void move_monster(Monster * monster) {
                     cell = board[new_coord.y][new_coord.x];
                     if (cell.hardness > 0) {
                         board[cell.y][cell.x].hardness -= 85;
+                        terrain_changed = true;
                         if (board[cell.y][cell.x].hardness <= 0) {
                             board[cell.y][cell.x].hardness = 0;
                             board[cell.y][cell.x].type = TYPE_CORRIDOR;
@@ -2655,6 +2801,7 @@ void move_monster(Monster * monster) {
                 cell = board[new_coord.y][new_coord.x];
                 if (cell.hardness > 0) {
                     board[cell.y][cell.x].hardness -= 85;
+                    terrain_changed = true;
                     if (board[cell.y][cell.x].hardness <= 0) {
                         board[cell.y][cell.x].hardness = 0;
                         board[cell.y][cell.x].type = TYPE_CORRIDOR;
@@ -2676,6 +2823,7 @@ void move_monster(Monster * monster) {
                 new_coord.y = cell.y;
                 if (cell.hardness > 0) {
                     board[cell.y][cell.x].hardness -= 85;
+                    terrain_changed = true;
                     if (board[cell.y][cell.x].hardness <= 0) {
                         board[cell.y][cell.x].hardness = 0;
                         board[cell.y][cell.x].type = TYPE_CORRIDOR;
@@ -2695,6 +2843,8 @@ void move_monster(Monster * monster) {
     bool attacked_player = false;
     if (new_coord.y == player->y && new_coord.x == player->x) {
         attacked_player = true;
+        GameEvent event(EVENT_MONSTER_ATTACK, level->depth, monster_x, monster_y);
+        event.setName(monster->details->name);
         if (player->willDodgeAttack()) {
             add_message("You dodge the monster's attack!");
         }
@@ -2705,7 +2855,10 @@ void move_monster(Monster * monster) {
             int damage = monster->getAttackDamage();
             int actual_damage = player->damage(damage);
             add_message("Monster inflicted " + to_string(actual_damage) + " points of damage on you!");
+            event.amount = actual_damage;
         }
+        event.remaining = max(player->hitpoints, 0);
+        event_log.record(event);
     }
     else if (new_coord.x != monster_x || new_coord.y != monster_y) {
         if (board[new_coord.y][new_coord.x].monster != NULL) {
@@ -2713,6 +2866,13 @@ void move_monster(Monster * monster) {
         }
     }
     if (!attacked_player) {
+        if (new_coord.x != monster->x || new_coord.y != monster->y) {
+            GameEvent event(EVENT_MONSTER_MOVE, level->depth, monster->x, monster->y);
+            event.to_x = new_coord.x;
+            event.to_y = new_coord.y;
+            event.setName(monster->details->name);
+            event_log.record(event);
+        }
         board[monster->y][monster->x].monster = NULL;
         monster->x = new_coord.x;
         monster->y = new_coord.y;
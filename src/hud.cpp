@@ -0,0 +1,38 @@
+#include <algorithm>
+#include "hud.h"
+
+const string & Hud :: getBar(int bar, float percentage) {
+    int fill = percentage * STATUS_BAR_WIDTH;
+    fill = max(0, min(fill, STATUS_BAR_WIDTH));
+    if (fill != bar_fills[bar]) {
+        bar_fills[bar] = fill;
+        bars[bar] = "|" + string(fill, '#') + string(STATUS_BAR_WIDTH - fill, ' ') + "|";
+    }
+    return bars[bar];
+}
+
+const string & Hud :: getMonstersLine(int remaining) {
+    if (remaining != monsters_remaining) {
+        monsters_remaining = remaining;
+        monsters_line = "Monsters remaining: " + to_string(remaining);
+    }
+    return monsters_line;
+}
+
+const string & Hud :: getRoomsLine(int explored, int total) {
+    if (explored != explored_rooms || total != total_rooms) {
+        explored_rooms = explored;
+        total_rooms = total;
+        rooms_line = "Rooms explored: " + to_string(explored) + "/" + to_string(total);
+    }
+    return rooms_line;
+}
+
+Hud :: Hud() {
+    for (int i = 0; i < NUMBER_OF_BARS; i++) {
+        bar_fills[i] = -1;
+    }
+    monsters_remaining = -1;
+    explored_rooms = -1;
+    total_rooms = -1;
+}
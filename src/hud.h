@@ -0,0 +1,37 @@
+#ifndef HUD_H
+#define HUD_H
+
+#include <string>
+
+#define STATUS_BAR_WIDTH 30
+#define HEALTH_BAR 0
+#define STAMINA_BAR 1
+#define MAGIC_BAR 2
+#define XP_BAR 3
+#define NUMBER_OF_BARS 4
+
+using namespace std;
+
+/*
+ * The text shown under the board. Every line is cached along with the value
+ * it was rendered from and only rebuilt when that value changes, so redrawing
+ * the HUD several times a turn does not allocate.
+ */
+class Hud {
+    private:
+        string bars[NUMBER_OF_BARS];
+        int bar_fills[NUMBER_OF_BARS];
+        string monsters_line;
+        int monsters_remaining;
+        string rooms_line;
+        int explored_rooms;
+        int total_rooms;
+
+    public:
+        const string & getBar(int bar, float percentage);
+        const string & getMonstersLine(int remaining);
+        const string & getRoomsLine(int explored, int total);
+        Hud();
+};
+
+#endif
@@ -0,0 +1,74 @@
+#include "job_scheduler.h"
+#include "profiler.h"
+
+JobScheduler :: JobScheduler(const char * name) : cancelled(false) {
+    this->name = name;
+    has_pending_job = false;
+    job_running = false;
+    stopping = false;
+}
+
+JobScheduler :: ~JobScheduler() {
+    stop();
+}
+
+void JobScheduler :: schedule(const Job & job) {
+    lock_guard<mutex> lock(jobs_mutex);
+    if (stopping) {
+        return;
+    }
+    pending_job = job;
+    has_pending_job = true;
+    if (!worker.joinable()) {
+        worker = thread(&JobScheduler::run, this);
+    }
+    jobs_changed.notify_all();
+}
+
+/*
+ * Drops the waiting job, asks the running one to stop and returns once it
+ * has. Nothing scheduled before the call runs or finishes after it.
+ */
+void JobScheduler :: cancel() {
+    unique_lock<mutex> lock(jobs_mutex);
+    has_pending_job = false;
+    pending_job = Job();
+    if (job_running) {
+        cancelled = true;
+        jobs_changed.wait(lock, [this] { return !job_running; });
+    }
+}
+
+void JobScheduler :: stop() {
+    cancel();
+    {
+        lock_guard<mutex> lock(jobs_mutex);
+        stopping = true;
+        jobs_changed.notify_all();
+    }
+    if (worker.joinable()) {
+        worker.join();
+    }
+}
+
+void JobScheduler :: run() {
+    trace_thread_name(name);
+    unique_lock<mutex> lock(jobs_mutex);
+    while (true) {
+        jobs_changed.wait(lock, [this] { return has_pending_job || stopping; });
+        if (stopping) {
+            return;
+        }
+        Job job = move(pending_job);
+        pending_job = Job();
+        has_pending_job = false;
+        job_running = true;
+        cancelled = false;
+        lock.unlock();
+        job(cancelled);
+        job = Job();
+        lock.lock();
+        job_running = false;
+        jobs_changed.notify_all();
+    }
+}
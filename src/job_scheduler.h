@@ -0,0 +1,49 @@
+#ifndef JOB_SCHEDULER_H
+#define JOB_SCHEDULER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+using namespace std;
+
+/*
+ * A job gets a flag that is raised when it has been cancelled; long jobs
+ * check it now and then and return early without publishing anything.
+ */
+typedef function<void(const atomic<bool> & cancelled)> Job;
+
+/*
+ * Runs jobs one at a time on a worker thread that sleeps while there is
+ * nothing to do. At most one job waits behind the running one: scheduling
+ * replaces a job that has not started yet, so a burst of requests costs at
+ * most one extra run. The running job is left to finish, so a steady stream
+ * of requests still publishes results. Only cancel() and stop() interrupt it.
+ * The worker is started by the first schedule().
+ */
+class JobScheduler {
+    private:
+        const char * name;
+        mutex jobs_mutex;
+        condition_variable jobs_changed;
+        Job pending_job;
+        bool has_pending_job;
+        bool job_running;
+        bool stopping;
+        atomic<bool> cancelled;
+        thread worker;
+        void run();
+        JobScheduler(const JobScheduler &);
+        JobScheduler & operator=(const JobScheduler &);
+
+    public:
+        void schedule(const Job & job);
+        void cancel();
+        void stop();
+        JobScheduler(const char * name);
+        ~JobScheduler();
+};
+
+#endif
@@ -0,0 +1,423 @@
+#include <string.h>
+#include <limits.h>
+#include <map>
+#include <netinet/in.h>
+#include "level.h"
+
+static const uint8_t CODE_ROCK = 0;
+static const uint8_t CODE_ROOM = 1;
+static const uint8_t CODE_CORRIDOR = 2;
+static const uint8_t CODE_UPSTAIR = 3;
+static const uint8_t CODE_DOWNSTAIR = 4;
+static const uint8_t CODE_UNSEEN = 5;
+
+static uint8_t type_to_code(const string & type) {
+    if (type.compare(TYPE_ROOM) == 0) {
+        return CODE_ROOM;
+    }
+    if (type.compare(TYPE_CORRIDOR) == 0) {
+        return CODE_CORRIDOR;
+    }
+    if (type.compare(TYPE_UPSTAIR) == 0) {
+        return CODE_UPSTAIR;
+    }
+    if (type.compare(TYPE_DOWNSTAIR) == 0) {
+        return CODE_DOWNSTAIR;
+    }
+    return CODE_ROCK;
+}
+
+static const string & code_to_type(uint8_t code) {
+    if (code == CODE_ROOM) {
+        return TYPE_ROOM;
+    }
+    if (code == CODE_CORRIDOR) {
+        return TYPE_CORRIDOR;
+    }
+    if (code == CODE_UPSTAIR) {
+        return TYPE_UPSTAIR;
+    }
+    if (code == CODE_DOWNSTAIR) {
+        return TYPE_DOWNSTAIR;
+    }
+    return TYPE_ROCK;
+}
+
+static void write_int(vector<uint8_t> & buffer, int32_t value) {
+    uint8_t bytes[4];
+    memcpy(bytes, &value, 4);
+    buffer.insert(buffer.end(), bytes, bytes + 4);
+}
+
+static void write_string(vector<uint8_t> & buffer, const string & str) {
+    write_int(buffer, str.length());
+    buffer.insert(buffer.end(), str.begin(), str.end());
+}
+
+static void write_numeric(vector<uint8_t> & buffer, const Numeric & numeric) {
+    write_int(buffer, numeric.base);
+    write_int(buffer, numeric.dice);
+    write_int(buffer, numeric.sides);
+}
+
+static int32_t read_int(const vector<uint8_t> & buffer, size_t & offset) {
+    int32_t value;
+    memcpy(&value, &buffer[offset], 4);
+    offset += 4;
+    return value;
+}
+
+static string read_string(const vector<uint8_t> & buffer, size_t & offset) {
+    int32_t length = read_int(buffer, offset);
+    string str(buffer.begin() + offset, buffer.begin() + offset + length);
+    offset += length;
+    return str;
+}
+
+static Numeric read_numeric(const vector<uint8_t> & buffer, size_t & offset) {
+    Numeric numeric;
+    numeric.base = read_int(buffer, offset);
+    numeric.dice = read_int(buffer, offset);
+    numeric.sides = read_int(buffer, offset);
+    return numeric;
+}
+
+/*
+ * Packs the level into a compact byte buffer. Each cell takes two bytes: its
+ * hardness, and the real and remembered cell types packed into one nibble each.
+ * Distance maps are not stored; they are recomputed when the level is restored.
+ */
+void Level :: serialize(vector<uint8_t> & buffer) {
+    buffer.clear();
+    buffer.reserve(2 * HEIGHT * WIDTH + 1024);
+    write_int(buffer, depth);
+    write_int(buffer, stair);
+    write_int(buffer, player_position.x);
+    write_int(buffer, player_position.y);
+    vector<Object *> objects;
+    for (int y = 0; y < HEIGHT; y++) {
+        for (int x = 0; x < WIDTH; x++) {
+            Board_Cell & cell = board[y][x];
+            Board_Cell & remembered = player_board[y][x];
+            uint8_t remembered_code = type_to_code(remembered.type);
+            if (remembered_code == CODE_ROCK && remembered.hardness == IMMUTABLE_ROCK) {
+                remembered_code = CODE_UNSEEN;
+            }
+            buffer.push_back(cell.hardness);
+            buffer.push_back(type_to_code(cell.type) | (remembered_code << 4));
+            if (cell.object) {
+                objects.push_back(cell.object);
+            }
+        }
+    }
+
+    write_int(buffer, rooms.size());
+    for (size_t i = 0; i < rooms.size(); i++) {
+        struct Room room = rooms[i];
+        buffer.push_back(room.start_x);
+        buffer.push_back(room.start_y);
+        buffer.push_back(room.end_x);
+        buffer.push_back(room.end_y);
+        buffer.push_back(room.has_explored);
+    }
+
+    write_int(buffer, monsters.size());
+    for (size_t i = 0; i < monsters.size(); i++) {
+        Monster * monster = monsters[i];
+        buffer.push_back(monster->x);
+        buffer.push_back(monster->y);
+        const MonsterDetails & details = *monster->details;
+        write_string(buffer, details.name);
+        write_string(buffer, details.description);
+        write_string(buffer, details.color);
+        buffer.push_back(details.symbol);
+        write_int(buffer, details.abilities.size());
+        for (size_t j = 0; j < details.abilities.size(); j++) {
+            write_string(buffer, details.abilities[j]);
+        }
+        write_int(buffer, monster->last_known_player_x);
+        write_int(buffer, monster->last_known_player_y);
+        write_int(buffer, monster->speed);
+        write_int(buffer, monster->hitpoints);
+        write_int(buffer, monster->max_hitpoints);
+        write_int(buffer, monster->experience);
+        write_int(buffer, monster->turn_health_regenerated);
+        write_numeric(buffer, monster->attack_damage);
+    }
+
+    write_int(buffer, objects.size());
+    for (size_t i = 0; i < objects.size(); i++) {
+        Object * object = objects[i];
+        buffer.push_back(object->x);
+        buffer.push_back(object->y);
+        write_string(buffer, object->name);
+        write_string(buffer, object->description);
+        write_string(buffer, object->type);
+        write_string(buffer, object->color);
+        write_int(buffer, object->hit_bonus);
+        write_numeric(buffer, object->damage_bonus);
+        write_int(buffer, object->dodge_bonus);
+        write_int(buffer, object->defense_bonus);
+        write_int(buffer, object->weight);
+        write_int(buffer, object->speed_bonus);
+        write_int(buffer, object->special_attribute);
+        write_int(buffer, object->value);
+        write_int(buffer, object->cost);
+    }
+}
+
+void Level :: deserialize(const vector<uint8_t> & buffer) {
+    destroyEntities();
+    rooms.clear();
+    size_t offset = 0;
+    depth = read_int(buffer, offset);
+    stair = read_int(buffer, offset);
+    player_position.x = read_int(buffer, offset);
+    player_position.y = read_int(buffer, offset);
+    for (int y = 0; y < HEIGHT; y++) {
+        for (int x = 0; x < WIDTH; x++) {
+            uint8_t hardness = buffer[offset++];
+            uint8_t codes = buffer[offset++];
+            uint8_t remembered_code = codes >> 4;
+            Board_Cell & cell = board[y][x];
+            cell.x = x;
+            cell.y = y;
+            cell.hardness = hardness;
+            cell.type = code_to_type(codes & 0x0F);
+            cell.tunneling_distance = INT_MAX;
+            cell.non_tunneling_distance = INT_MAX;
+            cell.monster = NULL;
+            cell.object = NULL;
+            Board_Cell & remembered = player_board[y][x];
+            remembered = cell;
+            if (remembered_code == CODE_UNSEEN) {
+                remembered.hardness = IMMUTABLE_ROCK;
+            }
+            remembered.type = code_to_type(remembered_code);
+        }
+    }
+
+    int number_of_rooms = read_int(buffer, offset);
+    number_of_explored_rooms = 0;
+    for (int i = 0; i < number_of_rooms; i++) {
+        struct Room room;
+        room.start_x = buffer[offset++];
+        room.start_y = buffer[offset++];
+        room.end_x = buffer[offset++];
+        room.end_y = buffer[offset++];
+        room.has_explored = buffer[offset++];
+        if (room.has_explored) {
+            number_of_explored_rooms ++;
+        }
+        rooms.push_back(room);
+    }
+    indexRooms();
+
+    // Monsters of the same name share one details record, as they did when
+    // they were made from their template
+    map<string, shared_ptr<const MonsterDetails> > monster_details;
+    int number_of_monsters = read_int(buffer, offset);
+    for (int i = 0; i < number_of_monsters; i++) {
+        Monster * monster = monster_pool.create();
+        monster->x = buffer[offset++];
+        monster->y = buffer[offset++];
+        MonsterDetails * details = new MonsterDetails();
+        details->name = read_string(buffer, offset);
+        details->description = read_string(buffer, offset);
+        details->color = read_string(buffer, offset);
+        details->symbol = buffer[offset++];
+        int number_of_abilities = read_int(buffer, offset);
+        for (int j = 0; j < number_of_abilities; j++) {
+            details->abilities.push_back(read_string(buffer, offset));
+        }
+        shared_ptr<const MonsterDetails> & shared_details = monster_details[details->name];
+        if (shared_details) {
+            delete details;
+        }
+        else {
+            shared_details.reset(details);
+        }
+        monster->details = shared_details;
+        monster->last_known_player_x = read_int(buffer, offset);
+        monster->last_known_player_y = read_int(buffer, offset);
+        monster->speed = read_int(buffer, offset);
+        monster->hitpoints = read_int(buffer, offset);
+        monster->max_hitpoints = read_int(buffer, offset);
+        monster->experience = read_int(buffer, offset);
+        monster->turn_health_regenerated = read_int(buffer, offset);
+        monster->attack_damage = read_numeric(buffer, offset);
+        monster->updateDecimalType();
+        board[monster->y][monster->x].monster = monster;
+        addMonster(monster);
+    }
+
+    int number_of_objects = read_int(buffer, offset);
+    for (int i = 0; i < number_of_objects; i++) {
+        Object * object = object_pool.create();
+        object->x = buffer[offset++];
+        object->y = buffer[offset++];
+        object->name = read_string(buffer, offset);
+        object->description = read_string(buffer, offset);
+        object->type = read_string(buffer, offset);
+        object->object_type = parseObjectType(object->type);
+        object->color = read_string(buffer, offset);
+        object->hit_bonus = read_int(buffer, offset);
+        object->damage_bonus = read_numeric(buffer, offset);
+        object->dodge_bonus = read_int(buffer, offset);
+        object->defense_bonus = read_int(buffer, offset);
+        object->weight = read_int(buffer, offset);
+        object->speed_bonus = read_int(buffer, offset);
+        object->special_attribute = read_int(buffer, offset);
+        object->value = read_int(buffer, offset);
+        object->cost = read_int(buffer, offset);
+        board[object->y][object->x].object = object;
+    }
+    needs_distance_update = true;
+}
+
+/*
+ * Writes the terrain in the RLG327 dungeon file format: marker, version, file
+ * size, one hardness byte per cell and four bytes per room.
+ */
+void Level :: writeDungeonFile(FILE * fp) {
+    string file_marker = "RLG327-S2017";
+    uint32_t version = htonl(0);
+    uint32_t file_size = htonl(16820 + (rooms.size() * 4));
+
+    fwrite(file_marker.c_str(), 1, file_marker.length(), fp);
+    fwrite(&version, 1, 4, fp);
+    fwrite(&file_size, 1, 4, fp);
+    for (int y = 0; y < HEIGHT; y++) {
+        for (int x = 0; x < WIDTH; x++) {
+            uint8_t num = board[y][x].hardness;
+            fwrite(&num, 1, 1, fp);
+        }
+    }
+
+    for (size_t i = 0; i < rooms.size(); i++) {
+        struct Room room = rooms[i];
+        uint8_t start_x = room.start_x;
+        uint8_t start_y = room.start_y;
+        uint8_t height = room.end_y - room.start_y + 1;
+        uint8_t width = room.end_x - room.start_x + 1;
+        fwrite(&start_x, 1, 1, fp);
+        fwrite(&start_y, 1, 1, fp);
+        fwrite(&(width), 1, 1, fp);
+        fwrite(&(height), 1, 1, fp);
+    }
+}
+
+void Level :: indexRooms() {
+    for (int y = 0; y < HEIGHT; y++) {
+        for (int x = 0; x < WIDTH; x++) {
+            room_ids[y][x] = -1;
+        }
+    }
+    // Filled last to first so overlapping rooms resolve to the first one
+    for (int i = rooms.size() - 1; i >= 0; i--) {
+        struct Room room = rooms[i];
+        for (int y = room.start_y; y <= room.end_y; y++) {
+            for (int x = room.start_x; x <= room.end_x; x++) {
+                room_ids[y][x] = i;
+            }
+        }
+    }
+}
+
+int Level :: getRoomIndexAt(int x, int y) {
+    return room_ids[y][x];
+}
+
+/*
+ * Marks a room explored and keeps number_of_explored_rooms in step. Returns
+ * whether the room was unexplored before.
+ */
+bool Level :: exploreRoom(int index) {
+    if (rooms[index].has_explored) {
+        return false;
+    }
+    rooms[index].has_explored = true;
+    number_of_explored_rooms ++;
+    return true;
+}
+
+void Level :: addMonster(Monster * monster) {
+    monster->monster_index = monsters.size();
+    monsters.push_back(monster);
+}
+
+/*
+ * Removes a monster from the monster list in constant time by moving the
+ * last monster into its place, and returns it to the pool.
+ */
+void Level :: removeMonster(Monster * monster) {
+    int index = monster->monster_index;
+    Monster * last = monsters.back();
+    monsters[index] = last;
+    last->monster_index = index;
+    monsters.pop_back();
+    monster_pool.destroy(monster);
+}
+
+/*
+ * Moves an object from the level's pool to the heap, for the player to
+ * carry. The pooled object is destroyed and the caller owns the copy.
+ */
+Object * Level :: releaseObject(Object * object) {
+    Object * carried = new Object(*object);
+    object_pool.destroy(object);
+    return carried;
+}
+
+/*
+ * Moves a heap object, such as one the player drops, into the level's pool.
+ * The heap object is deleted; the pooled copy is returned.
+ */
+Object * Level :: adoptObject(Object * object) {
+    Object * pooled = object_pool.create(*object);
+    delete object;
+    return pooled;
+}
+
+void Level :: destroyEntities() {
+    monsters.clear();
+    for (int y = 0; y < HEIGHT; y++) {
+        for (int x = 0; x < WIDTH; x++) {
+            board[y][x].object = NULL;
+            board[y][x].monster = NULL;
+            player_board[y][x].object = NULL;
+            player_board[y][x].monster = NULL;
+        }
+    }
+    monster_pool.clear();
+    object_pool.clear();
+}
+
+LevelKey Level :: getKey() const {
+    LevelKey key;
+    key.depth = depth;
+    key.stair = stair;
+    return key;
+}
+
+Level :: Level() {
+    depth = 0;
+    stair = 0;
+    needs_distance_update = false;
+    number_of_explored_rooms = 0;
+    player_position.x = 0;
+    player_position.y = 0;
+    for (int y = 0; y < HEIGHT; y++) {
+        for (int x = 0; x < WIDTH; x++) {
+            board[y][x].monster = NULL;
+            board[y][x].object = NULL;
+            player_board[y][x].monster = NULL;
+            player_board[y][x].object = NULL;
+            room_ids[y][x] = -1;
+        }
+    }
+}
+
+Level :: ~Level() {
+    destroyEntities();
+}
@@ -0,0 +1,103 @@
+#ifndef LEVEL_H
+#define LEVEL_H
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include <stdio.h>
+#include "util.h"
+#include "monster.h"
+#include "object.h"
+#include "entity_pool.h"
+
+#define HEIGHT 105
+#define WIDTH 160
+#define IMMUTABLE_ROCK 255
+#define ROCK 200
+#define ROOM 0
+#define CORRIDOR 0
+
+using namespace std;
+
+static const string TYPE_ROOM = "room";
+static const string TYPE_CORRIDOR = "corridor";
+static const string TYPE_ROCK = "rock";
+static const string TYPE_UPSTAIR = "upstair";
+static const string TYPE_DOWNSTAIR = "downstair";
+
+typedef struct {
+    int tunneling_distance;
+    int non_tunneling_distance;
+    int hardness;
+    string type;
+    int x;
+    int y;
+    Monster *monster;
+    Object * object;
+} Board_Cell;
+
+struct Room {
+    int start_x;
+    int end_x;
+    int start_y;
+    int end_y;
+    bool has_explored;
+};
+
+/*
+ * Identifies a level: its depth and the staircase that first led to it. Two
+ * staircases going down from the same level lead to different levels.
+ */
+struct LevelKey {
+    int depth;
+    int stair;
+    bool operator<(const LevelKey & other) const {
+        return depth < other.depth || (depth == other.depth && stair < other.stair);
+    }
+    bool operator==(const LevelKey & other) const {
+        return depth == other.depth && stair == other.stair;
+    }
+};
+
+/*
+ * A single dungeon level. A level owns the monsters in its monster list and
+ * every object lying on its board, all allocated from its pools and released
+ * together. Objects the player is carrying are moved out to the heap with
+ * releaseObject; they belong to the player and are never destroyed with the
+ * level.
+ */
+class Level {
+    private:
+
+    public:
+        int depth;
+        int stair;
+        bool needs_distance_update;
+        struct Coordinate player_position;
+        Board_Cell board[HEIGHT][WIDTH];
+        Board_Cell player_board[HEIGHT][WIDTH];
+        // Index into rooms of the room covering each cell, or -1
+        int16_t room_ids[HEIGHT][WIDTH];
+        vector<struct Room> rooms;
+        int number_of_explored_rooms;
+        vector<Monster *> monsters;
+        EntityPool<Monster> monster_pool;
+        EntityPool<Object> object_pool;
+
+        LevelKey getKey() const;
+        void serialize(vector<uint8_t> & buffer);
+        void deserialize(const vector<uint8_t> & buffer);
+        void writeDungeonFile(FILE * fp);
+        void indexRooms();
+        int getRoomIndexAt(int x, int y);
+        bool exploreRoom(int index);
+        void addMonster(Monster * monster);
+        void removeMonster(Monster * monster);
+        Object * releaseObject(Object * object);
+        Object * adoptObject(Object * object);
+        void destroyEntities();
+        Level();
+        ~Level();
+};
+
+#endif
@@ -0,0 +1,69 @@
+#include "level_cache.h"
+
+bool LevelCache :: contains(const LevelKey & key) {
+    return resident_levels.count(key) || evicted_levels.count(key);
+}
+
+void LevelCache :: store(Level * level) {
+    LevelKey key = level->getKey();
+    forgetEvicted(key);
+    resident_levels[key] = level;
+    resident_order.remove(key);
+    resident_order.push_front(key);
+    while (resident_order.size() > MAX_RESIDENT_LEVELS) {
+        evictLeastRecentlyUsed();
+    }
+}
+
+Level * LevelCache :: take(const LevelKey & key) {
+    map<LevelKey, Level *>::iterator it = resident_levels.find(key);
+    if (it != resident_levels.end()) {
+        Level * level = it->second;
+        resident_levels.erase(it);
+        resident_order.remove(key);
+        return level;
+    }
+    map<LevelKey, vector<uint8_t> >::iterator evicted = evicted_levels.find(key);
+    if (evicted != evicted_levels.end()) {
+        Level * level = new Level();
+        level->deserialize(evicted->second);
+        forgetEvicted(key);
+        return level;
+    }
+    return NULL;
+}
+
+void LevelCache :: evictLeastRecentlyUsed() {
+    LevelKey key = resident_order.back();
+    resident_order.pop_back();
+    Level * level = resident_levels[key];
+    resident_levels.erase(key);
+    level->serialize(evicted_levels[key]);
+    evicted_order.push_front(key);
+    delete level;
+    while (evicted_order.size() > MAX_EVICTED_LEVELS) {
+        LevelKey oldest = evicted_order.back();
+        forgetEvicted(oldest);
+    }
+}
+
+void LevelCache :: forgetEvicted(const LevelKey & key) {
+    if (evicted_levels.erase(key)) {
+        evicted_order.remove(key);
+    }
+}
+
+void LevelCache :: clear() {
+    map<LevelKey, Level *>::iterator it;
+    for (it = resident_levels.begin(); it != resident_levels.end(); it++) {
+        delete it->second;
+    }
+    resident_levels.clear();
+    resident_order.clear();
+    evicted_levels.clear();
+    evicted_order.clear();
+}
+
+LevelCache :: ~LevelCache() {
+    clear();
+}
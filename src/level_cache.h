@@ -0,0 +1,42 @@
+#ifndef LEVEL_CACHE_H
+#define LEVEL_CACHE_H
+
+#include <list>
+#include <map>
+#include <vector>
+#include <stdint.h>
+#include "level.h"
+
+using namespace std;
+
+/*
+ * Keeps levels the player has left so that stairs lead back to the same
+ * level. Levels are keyed by depth and stair. The most recently stored levels
+ * stay resident; older ones are packed with Level::serialize and rebuilt on
+ * demand. Only the MAX_EVICTED_LEVELS most recently packed levels are kept;
+ * older ones are forgotten and built anew if the player goes back.
+ *
+ * The caller must make sure nothing else is still using a level it stores,
+ * since the cache may delete it right away.
+ */
+class LevelCache {
+    private:
+        static const size_t MAX_RESIDENT_LEVELS = 3;
+        static const size_t MAX_EVICTED_LEVELS = 64;
+        list<LevelKey> resident_order;
+        map<LevelKey, Level *> resident_levels;
+        list<LevelKey> evicted_order;
+        map<LevelKey, vector<uint8_t> > evicted_levels;
+        void evictLeastRecentlyUsed();
+        void forgetEvicted(const LevelKey & key);
+
+    public:
+        bool contains(const LevelKey & key);
+        void store(Level * level);
+        Level * take(const LevelKey & key);
+        void clear();
+        LevelCache() {};
+        ~LevelCache();
+};
+
+#endif
@@ -0,0 +1,475 @@
+#include <limits.h>
+#include <algorithm>
+#include "level_generator.h"
+
+int LevelGenerator :: randomInt(int min_num, int max_num) {
+    if (min_num > max_num) {
+       int tmp = min_num;
+       min_num = max_num;
+       max_num = tmp;
+    }
+    uniform_int_distribution<int> uni(min_num, max_num);
+    return uni(rng);
+}
+
+void LevelGenerator :: generate(Level * level) {
+    initializeBoard(level);
+    int num_rooms = randomInt(MIN_NUMBER_OF_ROOMS, MAX_NUMBER_OF_ROOMS);
+    if (room_placement == BSP_PLACEMENT) {
+        digRoomsWithBSP(level, num_rooms);
+    }
+    else {
+        digRooms(level, num_rooms);
+    }
+    digCorridors(level);
+    generateStairs(level);
+    level->player_position = getRandomLocationInRoom(level->rooms[0]);
+}
+
+void LevelGenerator :: initializeBoard(Level * level) {
+    Board_Cell cell;
+    cell.type = TYPE_ROCK;
+    cell.monster = NULL;
+    cell.object = NULL;
+    for (int y = 0; y < HEIGHT; y++) {
+        for (int x = 0; x < WIDTH; x++) {
+            cell.x = x;
+            cell.y = y;
+            cell.hardness = randomInt(1, 254);
+            level->board[y][x] = cell;
+            cell.hardness = IMMUTABLE_ROCK;
+            level->player_board[y][x] = cell;
+        }
+    }
+    level->rooms.clear();
+    initializeImmutableRock(level);
+}
+
+void LevelGenerator :: initializeImmutableRock(Level * level) {
+    int y;
+    int x;
+    int max_x = WIDTH - 1;
+    int max_y = HEIGHT - 1;
+    Board_Cell cell;
+    cell.type = TYPE_ROCK;
+    cell.hardness = IMMUTABLE_ROCK;
+    cell.monster = NULL;
+    cell.object = NULL;
+    for (y = 0; y < HEIGHT; y++) {
+        cell.y = y;
+        cell.x = 0;
+        level->board[y][0] = cell;
+        cell.x = max_x;
+        level->board[y][max_x] = cell;
+    }
+    for (x = 0; x < WIDTH; x++) {
+        cell.y = 0;
+        cell.x = x;
+        level->board[0][x] = cell;
+        cell.y = max_y;
+        level->board[max_y][x] = cell;
+    }
+}
+
+struct Coordinate LevelGenerator :: getRandomLocationInRoom(struct Room room) {
+    struct Coordinate coord;
+    coord.x = randomInt(room.start_x, room.end_x);
+    coord.y = randomInt(room.start_y, room.end_y);
+    return coord;
+}
+
+void LevelGenerator :: generateStairs(Level * level) {
+    size_t number_of_stairs_up = level->rooms.size() / 2;
+    for (size_t i = 0; i < number_of_stairs_up; i++) {
+        struct Room room = level->rooms[i];
+        struct Coordinate coord = getRandomLocationInRoom(room);
+        level->board[coord.y][coord.x].type = TYPE_UPSTAIR;
+    }
+    for (size_t i = number_of_stairs_up; i < level->rooms.size(); i++) {
+        struct Room room = level->rooms[i];
+        struct Coordinate coord = getRandomLocationInRoom(room);
+        level->board[coord.y][coord.x].type = TYPE_DOWNSTAIR;
+    }
+}
+
+void LevelGenerator :: digRooms(Level * level, int number_of_rooms_to_dig) {
+    rejected_rooms = 0;
+    for (int y = 0; y < ROOM_GRID_HEIGHT; y++) {
+        for (int x = 0; x < ROOM_GRID_WIDTH; x++) {
+            room_grid[y][x].clear();
+        }
+    }
+    for (size_t i = 0; i < level->rooms.size(); i++) {
+        addRoomToGrid(i, level->rooms[i]);
+    }
+    for (int i = 0; i < number_of_rooms_to_dig; i++) {
+        if (!digRoom(level)) {
+            break;
+        }
+    }
+    addRoomsToBoard(level);
+}
+
+/*
+ * Tries random rooms until one fits. Gives up after
+ * MAX_ROOM_PLACEMENT_ATTEMPTS so a crowded board ends up with fewer rooms
+ * instead of retrying forever.
+ */
+bool LevelGenerator :: digRoom(Level * level) {
+    for (int attempt = 0; attempt < MAX_ROOM_PLACEMENT_ATTEMPTS; attempt++) {
+        int start_x = randomInt(1, WIDTH - MIN_ROOM_WIDTH - 1);
+        int start_y = randomInt(1, HEIGHT - MIN_ROOM_HEIGHT - 1);
+        int room_height = randomInt(MIN_ROOM_HEIGHT, max_room_height);
+        int room_width = randomInt(MIN_ROOM_WIDTH, max_room_width);
+        int end_y = start_y + room_height;
+        if (end_y >= HEIGHT - 1) {
+            end_y = HEIGHT - 2;
+
+        }
+        int end_x = start_x + room_width;
+        if (end_x >= WIDTH - 1) {
+            end_x = WIDTH - 2;
+
+        }
+        int height = end_y - start_y;
+        int height_diff = MIN_ROOM_HEIGHT - height;
+        if (height_diff > 0) {
+            start_y -= height_diff + 1;
+        }
+
+        int width = end_x - start_x;
+        int width_diff = MIN_ROOM_WIDTH - width;
+        if (width_diff > 0) {
+            start_x -= width_diff + 1;
+        }
+        struct Room room;
+        room.start_x = start_x;
+        room.start_y = start_y;
+        room.end_x = end_x;
+        room.end_y = end_y;
+        room.has_explored = false;
+        if (roomIsValid(level, room)) {
+            addRoomToGrid(level->rooms.size(), room);
+            level->rooms.push_back(room);
+            return true;
+        }
+        rejected_rooms ++;
+    }
+    return false;
+}
+
+/*
+ * A room is valid when it is big enough, inside the border and at least one
+ * cell away from every other room. Only rooms registered in the grid cells
+ * the candidate covers are compared against it.
+ */
+bool LevelGenerator :: roomIsValid(Level * level, struct Room room) {
+    int width = room.end_x - room.start_x;
+    int height = room.end_y - room.start_y;
+    if (height < MIN_ROOM_HEIGHT || width < MIN_ROOM_WIDTH) {
+        return false;
+    }
+    if (room.start_x < 1 || room.start_y < 1 || room.end_x > WIDTH - 2 || room.end_y > HEIGHT - 2) {
+        return false;
+    }
+    int min_grid_x = room.start_x / ROOM_GRID_CELL_SIZE;
+    int max_grid_x = room.end_x / ROOM_GRID_CELL_SIZE;
+    int min_grid_y = room.start_y / ROOM_GRID_CELL_SIZE;
+    int max_grid_y = room.end_y / ROOM_GRID_CELL_SIZE;
+    for (int grid_y = min_grid_y; grid_y <= max_grid_y; grid_y++) {
+        for (int grid_x = min_grid_x; grid_x <= max_grid_x; grid_x++) {
+            vector<int> & indexes = room_grid[grid_y][grid_x];
+            for (size_t i = 0; i < indexes.size(); i++) {
+                struct Room current_room = level->rooms[indexes[i]];
+                if (room.start_x <= current_room.end_x + 1 && room.end_x >= current_room.start_x - 1 &&
+                        room.start_y <= current_room.end_y + 1 && room.end_y >= current_room.start_y - 1) {
+                    return false;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+void LevelGenerator :: addRoomToGrid(int index, struct Room room) {
+    int min_grid_x = max(room.start_x - 1, 0) / ROOM_GRID_CELL_SIZE;
+    int max_grid_x = min(room.end_x + 1, WIDTH - 1) / ROOM_GRID_CELL_SIZE;
+    int min_grid_y = max(room.start_y - 1, 0) / ROOM_GRID_CELL_SIZE;
+    int max_grid_y = min(room.end_y + 1, HEIGHT - 1) / ROOM_GRID_CELL_SIZE;
+    for (int grid_y = min_grid_y; grid_y <= max_grid_y; grid_y++) {
+        for (int grid_x = min_grid_x; grid_x <= max_grid_x; grid_x++) {
+            room_grid[grid_y][grid_x].push_back(index);
+        }
+    }
+}
+
+/*
+ * Binary space partitioning: the board is cut into disjoint leaves and one
+ * room is placed inside each, so no candidate is ever rejected and the work
+ * is bounded by the number of rooms. Every room stays clear of the right and
+ * bottom edge of its leaf, which keeps neighbouring rooms a cell apart.
+ */
+void LevelGenerator :: digRoomsWithBSP(Level * level, int number_of_rooms_to_dig) {
+    rejected_rooms = 0;
+    vector<struct Room> leaves;
+    struct Room board_leaf;
+    board_leaf.start_x = 1;
+    board_leaf.start_y = 1;
+    board_leaf.end_x = WIDTH - 2;
+    board_leaf.end_y = HEIGHT - 2;
+    board_leaf.has_explored = false;
+    leaves.push_back(board_leaf);
+    splitLeaves(leaves, number_of_rooms_to_dig);
+
+    for (size_t i = 0; i < leaves.size(); i++) {
+        struct Room leaf = leaves[i];
+        int max_width = min(max_room_width, leaf.end_x - leaf.start_x - 1);
+        int max_height = min(max_room_height, leaf.end_y - leaf.start_y - 1);
+        int width = randomInt(MIN_ROOM_WIDTH, max_width);
+        int height = randomInt(MIN_ROOM_HEIGHT, max_height);
+        struct Room room;
+        room.start_x = randomInt(leaf.start_x, leaf.end_x - 1 - width);
+        room.start_y = randomInt(leaf.start_y, leaf.end_y - 1 - height);
+        room.end_x = room.start_x + width;
+        room.end_y = room.start_y + height;
+        room.has_explored = false;
+        level->rooms.push_back(room);
+    }
+    addRoomsToBoard(level);
+}
+
+/*
+ * Repeatedly halves the largest leaf that can still hold two rooms, cutting
+ * across its longer side, until there are enough leaves or none can be cut.
+ */
+void LevelGenerator :: splitLeaves(vector<struct Room> & leaves, int number_of_leaves) {
+    while ((int) leaves.size() < number_of_leaves) {
+        int largest_index = -1;
+        int largest_area = 0;
+        for (size_t i = 0; i < leaves.size(); i++) {
+            int width = leaves[i].end_x - leaves[i].start_x + 1;
+            int height = leaves[i].end_y - leaves[i].start_y + 1;
+            if (width < 2 * MIN_BSP_LEAF_WIDTH && height < 2 * MIN_BSP_LEAF_HEIGHT) {
+                continue;
+            }
+            if (width * height > largest_area) {
+                largest_area = width * height;
+                largest_index = i;
+            }
+        }
+        if (largest_index == -1) {
+            break;
+        }
+        struct Room leaf = leaves[largest_index];
+        struct Room other_leaf = leaf;
+        int width = leaf.end_x - leaf.start_x + 1;
+        int height = leaf.end_y - leaf.start_y + 1;
+        bool split_x = width >= 2 * MIN_BSP_LEAF_WIDTH;
+        if (split_x && height >= 2 * MIN_BSP_LEAF_HEIGHT) {
+            split_x = width * MIN_BSP_LEAF_HEIGHT >= height * MIN_BSP_LEAF_WIDTH;
+        }
+        if (split_x) {
+            int split = randomInt(leaf.start_x + MIN_BSP_LEAF_WIDTH, leaf.end_x - MIN_BSP_LEAF_WIDTH + 1);
+            leaf.end_x = split - 1;
+            other_leaf.start_x = split;
+        }
+        else {
+            int split = randomInt(leaf.start_y + MIN_BSP_LEAF_HEIGHT, leaf.end_y - MIN_BSP_LEAF_HEIGHT + 1);
+            leaf.end_y = split - 1;
+            other_leaf.start_y = split;
+        }
+        leaves[largest_index] = leaf;
+        leaves.push_back(other_leaf);
+    }
+}
+
+void LevelGenerator :: addRoomsToBoard(Level * level) {
+    Board_Cell cell;
+    cell.type = TYPE_ROOM;
+    cell.hardness = ROOM;
+    cell.monster = NULL;
+    cell.object = NULL;
+    for(size_t i = 0; i < level->rooms.size(); i++) {
+        struct Room room = level->rooms[i];
+        for (int y = room.start_y; y <= room.end_y; y++) {
+            for(int x = room.start_x; x <= room.end_x; x++) {
+                cell.x = x;
+                cell.y = y;
+                level->board[y][x] = cell;
+            }
+        }
+    }
+    level->indexRooms();
+}
+
+struct Coordinate LevelGenerator :: getRoomCenter(struct Room room) {
+    struct Coordinate center;
+    center.x = ((room.end_x - room.start_x) / 2) + room.start_x;
+    center.y = ((room.end_y - room.start_y) / 2) + room.start_y;
+    return center;
+}
+
+/*
+ * Connects the rooms along a minimum spanning tree over their centers, built
+ * with Prim's algorithm, plus EXTRA_CORRIDORS shortcuts from random rooms to
+ * their nearest room that is not already linked to them.
+ */
+void LevelGenerator :: digCorridors(Level * level) {
+    int number_of_rooms = level->rooms.size();
+    if (number_of_rooms < 2) {
+        return;
+    }
+    vector<struct Coordinate> centers;
+    for (int i = 0; i < number_of_rooms; i++) {
+        centers.push_back(getRoomCenter(level->rooms[i]));
+    }
+    vector<int> distances(number_of_rooms * number_of_rooms);
+    for (int i = 0; i < number_of_rooms; i++) {
+        for (int j = 0; j < number_of_rooms; j++) {
+            int dx = centers[i].x - centers[j].x;
+            int dy = centers[i].y - centers[j].y;
+            distances[i * number_of_rooms + j] = dx * dx + dy * dy;
+        }
+    }
+
+    for (int y = 0; y < HEIGHT; y++) {
+        for (int x = 0; x < WIDTH; x++) {
+            Board_Cell & cell = level->board[y][x];
+            if (cell.hardness == IMMUTABLE_ROCK) {
+                step_cost[y * WIDTH + x] = 0;
+            }
+            else if (cell.type.compare(TYPE_ROCK) == 0) {
+                step_cost[y * WIDTH + x] = 2 + cell.hardness / 32;
+            }
+            else {
+                step_cost[y * WIDTH + x] = 1;
+            }
+        }
+    }
+
+    vector<bool> linked(number_of_rooms * number_of_rooms, false);
+    vector<bool> in_tree(number_of_rooms, false);
+    vector<int> closest_distance(number_of_rooms, INT_MAX);
+    vector<int> closest_room(number_of_rooms, 0);
+    closest_distance[0] = 0;
+    for (int added = 0; added < number_of_rooms; added++) {
+        int next = -1;
+        for (int i = 0; i < number_of_rooms; i++) {
+            if (!in_tree[i] && (next == -1 || closest_distance[i] < closest_distance[next])) {
+                next = i;
+            }
+        }
+        in_tree[next] = true;
+        if (added) {
+            int other = closest_room[next];
+            linked[next * number_of_rooms + other] = true;
+            linked[other * number_of_rooms + next] = true;
+            routeCorridor(level, centers[other], centers[next]);
+        }
+        for (int i = 0; i < number_of_rooms; i++) {
+            if (!in_tree[i] && distances[next * number_of_rooms + i] < closest_distance[i]) {
+                closest_distance[i] = distances[next * number_of_rooms + i];
+                closest_room[i] = next;
+            }
+        }
+    }
+
+    for (int k = 0; k < EXTRA_CORRIDORS; k++) {
+        int from = randomInt(0, number_of_rooms - 1);
+        int to = -1;
+        for (int i = 0; i < number_of_rooms; i++) {
+            if (i == from || linked[from * number_of_rooms + i]) {
+                continue;
+            }
+            if (to == -1 || distances[from * number_of_rooms + i] < distances[from * number_of_rooms + to]) {
+                to = i;
+            }
+        }
+        if (to == -1) {
+            continue;
+        }
+        linked[from * number_of_rooms + to] = true;
+        linked[to * number_of_rooms + from] = true;
+        routeCorridor(level, centers[from], centers[to]);
+    }
+}
+
+/*
+ * A* from one room center to another over the 4-connected board. Stepping
+ * into open floor costs 1 and into rock 2 plus a share of its hardness, so
+ * corridors bend around hard rock and merge into existing corridors. Rock
+ * on the path is turned into corridor.
+ */
+void LevelGenerator :: routeCorridor(Level * level, struct Coordinate from, struct Coordinate to) {
+    static const int dx[] = { 1, -1, 0, 0 };
+    static const int dy[] = { 0, 0, 1, -1 };
+    route_stamp ++;
+    int start = from.y * WIDTH + from.x;
+    int goal = to.y * WIDTH + to.x;
+    route_heap.clear();
+    route_cost[start] = 0;
+    route_parent[start] = -1;
+    route_seen[start] = route_stamp;
+    route_heap.push_back(make_pair(0, start));
+    while (route_heap.size()) {
+        pop_heap(route_heap.begin(), route_heap.end(), greater<pair<int, int> >());
+        int index = route_heap.back().second;
+        route_heap.pop_back();
+        if (index == goal) {
+            break;
+        }
+        if (route_closed[index] == route_stamp) {
+            continue;
+        }
+        route_closed[index] = route_stamp;
+        int x = index % WIDTH;
+        int y = index / WIDTH;
+        for (int i = 0; i < 4; i++) {
+            int next_x = x + dx[i];
+            int next_y = y + dy[i];
+            int next = next_y * WIDTH + next_x;
+            if (!step_cost[next]) {
+                continue;
+            }
+            int cost = route_cost[index] + step_cost[next];
+            if (route_seen[next] != route_stamp || cost < route_cost[next]) {
+                route_seen[next] = route_stamp;
+                route_cost[next] = cost;
+                route_parent[next] = index;
+                int estimate = cost + ROUTE_HEURISTIC_WEIGHT * (abs(to.x - next_x) + abs(to.y - next_y));
+                route_heap.push_back(make_pair(estimate, next));
+                push_heap(route_heap.begin(), route_heap.end(), greater<pair<int, int> >());
+            }
+        }
+    }
+    if (route_seen[goal] != route_stamp) {
+        return;
+    }
+    Board_Cell corridor_cell;
+    corridor_cell.type = TYPE_CORRIDOR;
+    corridor_cell.hardness = CORRIDOR;
+    corridor_cell.monster = NULL;
+    corridor_cell.object = NULL;
+    for (int index = goal; index != -1; index = route_parent[index]) {
+        Board_Cell & cell = level->board[index / WIDTH][index % WIDTH];
+        step_cost[index] = 1;
+        if (cell.type.compare(TYPE_ROCK) == 0) {
+            corridor_cell.x = index % WIDTH;
+            corridor_cell.y = index / WIDTH;
+            cell = corridor_cell;
+        }
+    }
+}
+
+LevelGenerator :: LevelGenerator() : LevelGenerator(random_device()()) {
+}
+
+LevelGenerator :: LevelGenerator(unsigned int seed) : rng(seed),
+    step_cost(HEIGHT * WIDTH), route_cost(HEIGHT * WIDTH), route_parent(HEIGHT * WIDTH),
+    route_seen(HEIGHT * WIDTH, 0), route_closed(HEIGHT * WIDTH, 0) {
+    route_stamp = 0;
+    room_placement = RANDOM_PLACEMENT;
+    rejected_rooms = 0;
+    max_room_width = DEFAULT_MAX_ROOM_WIDTH;
+    max_room_height = DEFAULT_MAX_ROOM_HEIGHT;
+}
@@ -0,0 +1,80 @@
+#ifndef LEVEL_GENERATOR_H
+#define LEVEL_GENERATOR_H
+
+#include <random>
+#include "level.h"
+
+#define MIN_NUMBER_OF_ROOMS 25
+#define MAX_NUMBER_OF_ROOMS 40
+#define MIN_ROOM_WIDTH 7
+#define DEFAULT_MAX_ROOM_WIDTH 20
+#define MIN_ROOM_HEIGHT 5
+#define DEFAULT_MAX_ROOM_HEIGHT 15
+#define MAX_ROOM_PLACEMENT_ATTEMPTS 1000
+#define ROOM_GRID_CELL_SIZE 8
+#define ROOM_GRID_WIDTH ((WIDTH + ROOM_GRID_CELL_SIZE - 1) / ROOM_GRID_CELL_SIZE)
+#define ROOM_GRID_HEIGHT ((HEIGHT + ROOM_GRID_CELL_SIZE - 1) / ROOM_GRID_CELL_SIZE)
+#define RANDOM_PLACEMENT 0
+#define BSP_PLACEMENT 1
+// Smallest BSP leaf: a minimum sized room plus the gap kept to its neighbours
+#define MIN_BSP_LEAF_WIDTH (MIN_ROOM_WIDTH + 2)
+#define MIN_BSP_LEAF_HEIGHT (MIN_ROOM_HEIGHT + 2)
+// Corridors added on top of the spanning tree so the level has some loops
+#define EXTRA_CORRIDORS 3
+// Weight on the A* distance estimate; above 1 trades optimal routes for speed
+#define ROUTE_HEURISTIC_WEIGHT 4
+
+using namespace std;
+
+/*
+ * Digs the terrain of a level: rock hardness, rooms, corridors, stairs and
+ * the spot the player arrives on. A generator only writes to the Level it is
+ * given and draws from its own random number generator, so separate
+ * generators can build levels on separate threads at the same time.
+ */
+class LevelGenerator {
+    private:
+        mt19937 rng;
+        int max_room_width;
+        int max_room_height;
+        // Indexes of the rooms whose one cell margin touches each grid cell
+        vector<int> room_grid[ROOM_GRID_HEIGHT][ROOM_GRID_WIDTH];
+        // Scratch buffers for routing corridors, indexed by y * WIDTH + x and
+        // reused across routes. step_cost is 0 for cells a corridor may not
+        // enter. A cell's cost and parent are only meaningful when its stamp
+        // matches route_stamp.
+        vector<uint8_t> step_cost;
+        vector<int> route_cost;
+        vector<int> route_parent;
+        vector<int> route_seen;
+        vector<int> route_closed;
+        vector<pair<int, int> > route_heap;
+        int route_stamp;
+        int randomInt(int min_num, int max_num);
+        void initializeImmutableRock(Level * level);
+        bool digRoom(Level * level);
+        bool roomIsValid(Level * level, struct Room room);
+        void addRoomToGrid(int index, struct Room room);
+        void splitLeaves(vector<struct Room> & leaves, int number_of_leaves);
+        struct Coordinate getRoomCenter(struct Room room);
+        void routeCorridor(Level * level, struct Coordinate from, struct Coordinate to);
+
+    public:
+        // RANDOM_PLACEMENT or BSP_PLACEMENT
+        int room_placement;
+        // Candidate rooms thrown away by the last call to dig rooms
+        int rejected_rooms;
+
+        void generate(Level * level);
+        void initializeBoard(Level * level);
+        void digRooms(Level * level, int number_of_rooms_to_dig);
+        void digRoomsWithBSP(Level * level, int number_of_rooms_to_dig);
+        void addRoomsToBoard(Level * level);
+        void digCorridors(Level * level);
+        void generateStairs(Level * level);
+        struct Coordinate getRandomLocationInRoom(struct Room room);
+        LevelGenerator();
+        LevelGenerator(unsigned int seed);
+};
+
+#endif
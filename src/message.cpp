@@ -2,37 +2,104 @@
 #include <ctime>
 #include "message.h"
 
-Message::Message(string message) {
-    this->message = message;
-    time_t t = time(0);
-    this->timestamp = localtime(& t);
+static string two_digits(int value) {
+    string text = to_string(value);
+    if (value < 10) {
+        text = "0" + text;
+    }
+    return text;
+}
+
+string Message::getFormattedTime() const {
+    struct tm local;
+    localtime_r(&timestamp, &local);
+    string year = to_string(local.tm_year + 1900);
+    string month = two_digits(local.tm_mon + 1);
+    string day = two_digits(local.tm_mday);
+    string hour = two_digits(local.tm_hour);
+    string minute = two_digits(local.tm_min);
+    string second = two_digits(local.tm_sec);
+    return year + "-" + month + "-" + day + " at " + hour + ":" + minute + ":" + second;
+}
+
+MessageLog::MessageLog() {
+    entries.resize(MESSAGE_LOG_CAPACITY);
+    next_entry = 0;
+    entry_count = 0;
 }
 
-string Message::getFormattedTime() {
-    string year = to_string(timestamp->tm_year + 1900);
-    string month = to_string(timestamp->tm_mon);
-    if (timestamp->tm_mon < 10) {
-        month = "0" + month;
+int MessageLog::internText(const string & text) {
+    unordered_map<string, int>::iterator found = text_ids.find(text);
+    if (found != text_ids.end()) {
+        text_references[found->second] ++;
+        return found->second;
     }
-    string day = to_string(timestamp->tm_mday);
-    if (timestamp->tm_mday < 10) {
-        day = "0" + day;
+    int text_id;
+    if (free_text_ids.size()) {
+        text_id = free_text_ids.back();
+        free_text_ids.pop_back();
+        texts[text_id] = text;
     }
-    string hour = to_string(timestamp->tm_hour);
-    if (timestamp->tm_hour < 10) {
-        hour = "0" + hour;
+    else {
+        text_id = texts.size();
+        texts.push_back(text);
+        text_references.push_back(0);
     }
-    string minute = to_string(timestamp->tm_min);
-    if (timestamp->tm_min < 10) {
-        minute = "0" + minute;
+    text_references[text_id] = 1;
+    text_ids[text] = text_id;
+    return text_id;
+}
+
+void MessageLog::releaseText(int text_id) {
+    text_references[text_id] --;
+    if (!text_references[text_id]) {
+        text_ids.erase(texts[text_id]);
+        texts[text_id].clear();
+        free_text_ids.push_back(text_id);
     }
-    string second = to_string(timestamp->tm_sec);
-    if (timestamp->tm_sec < 10) {
-        second = "0" + second;
+}
+
+void MessageLog::add(const string & text) {
+    if (entry_count) {
+        Message & newest = entries[(next_entry + MESSAGE_LOG_CAPACITY - 1) % MESSAGE_LOG_CAPACITY];
+        if (texts[newest.text_id] == text) {
+            newest.repeat_count ++;
+            newest.timestamp = time(0);
+            return;
+        }
     }
-    return year + "-" + month + "-" + day + " at " + hour + ":" + minute + ":" + second;
+    Message & entry = entries[next_entry];
+    if (entry_count == MESSAGE_LOG_CAPACITY) {
+        releaseText(entry.text_id);
+    }
+    else {
+        entry_count ++;
+    }
+    entry.timestamp = time(0);
+    entry.text_id = internText(text);
+    entry.repeat_count = 1;
+    next_entry = (next_entry + 1) % MESSAGE_LOG_CAPACITY;
+}
+
+size_t MessageLog::size() const {
+    return entry_count;
 }
 
-string Message::toString() {
-    return getFormattedTime() + "\t" + message;
+/*
+ * Age 0 is the newest message.
+ */
+const Message & MessageLog::get(size_t age) const {
+    if (age >= entry_count) {
+        throw "Message log index out of range";
+    }
+    return entries[(next_entry + MESSAGE_LOG_CAPACITY - 1 - age) % MESSAGE_LOG_CAPACITY];
+}
+
+string MessageLog::toString(size_t age) const {
+    const Message & entry = get(age);
+    string text = entry.getFormattedTime() + "\t" + texts[entry.text_id];
+    if (entry.repeat_count > 1) {
+        text += " (x" + to_string(entry.repeat_count) + ")";
+    }
+    return text;
 }
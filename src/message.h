@@ -1,16 +1,56 @@
+#ifndef MESSAGE_H
+#define MESSAGE_H
+
 #include <string>
 #include <ctime>
+#include <vector>
+#include <unordered_map>
 
 using namespace std;
 
+#define MESSAGE_LOG_CAPACITY 1024
+
+/*
+ * One entry of the message log. The text is an id into the log's string
+ * table; a message repeated back to back bumps repeat_count instead of taking
+ * a new entry.
+ */
 class Message {
     private:
 
     public:
-        struct tm * timestamp;
-        string message;
-        Message(string message);
-        string getFormattedTime();
-        string toString();
+        time_t timestamp;
+        int text_id;
+        int repeat_count;
+        string getFormattedTime() const;
+
+};
 
+/*
+ * Fixed-capacity ring of the last MESSAGE_LOG_CAPACITY messages. Adding a
+ * message is constant time. A repeat of a text already in the log only bumps
+ * its reference count; a new text is copied into the string table, which
+ * allocates. A text is freed from the table when the last entry using it is
+ * overwritten.
+ */
+class MessageLog {
+    private:
+        vector<Message> entries;
+        size_t next_entry;
+        size_t entry_count;
+        vector<string> texts;
+        vector<int> text_references;
+        vector<int> free_text_ids;
+        unordered_map<string, int> text_ids;
+        int internText(const string & text);
+        void releaseText(int text_id);
+
+    public:
+        void add(const string & text);
+        size_t size() const;
+        const Message & get(size_t age) const;
+        string toString(size_t age) const;
+        MessageLog();
 };
+
+#endif
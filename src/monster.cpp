@@ -6,13 +6,17 @@ void Monster :: resetPlayerLocation() {
 }
 
 int Monster :: getAttackDamage() {
-    return attack_damage->roll();
+    if (attack_damage_roll) {
+        return attack_damage_roll->roll(thread_dice_random());
+    }
+    return attack_damage.roll();
 }
 
-int Monster :: getDecimalType() {
-    int decimal_type = 0;
+void Monster :: updateDecimalType() {
+    decimal_type = 0;
+    const vector<string> & abilities = details->abilities;
     for (size_t i = 0; i < abilities.size(); i++) {
-        string ability = abilities[i];
+        const string & ability = abilities[i];
         if (ability.compare("SMART") == 0) {
             decimal_type ++;
         }
@@ -26,5 +30,8 @@ int Monster :: getDecimalType() {
             decimal_type += 8;
         }
     }
+}
+
+int Monster :: getDecimalType() {
     return decimal_type;
 }
@@ -1,22 +1,47 @@
 #ifndef __MONSTER_H
 #define __MONSTER_H
 
+#include <memory>
 #include "character.h"
+#include "dice_distribution.h"
 
+/*
+ * What a monster is: everything that never changes once it is made. It is
+ * kept out of Monster so that walking the monster list touches only the
+ * state that changes during play, and every monster made from a template
+ * shares the template's record.
+ */
+struct MonsterDetails {
+    string name;
+    string description;
+    string color;
+    char symbol;
+    vector<string> abilities;
+};
+
+/*
+ * The per-turn state of a monster, allocated from its level's pool. The
+ * name, description and abilities live in details.
+ */
 class Monster : public Character {
     public:
-        string name;
-        string description;
-        string color;
-        char symbol;
-        vector<string> abilities;
+        shared_ptr<const MonsterDetails> details;
         int last_known_player_x;
         int last_known_player_y;
+        // Ability bits (SMART 1, TELE 2, TUNNEL 4, ERRATIC 8), worked out
+        // from abilities once by updateDecimalType
         int decimal_type;
+        // Position in the level's monster list, kept by Level
+        int monster_index;
+        // attack_damage compiled by the template the monster was made from.
+        // NULL for monsters restored from a cached level, which roll
+        // attack_damage directly.
+        const DiceDistribution * attack_damage_roll;
 
         int getAttackDamage();
         void resetPlayerLocation();
+        void updateDecimalType();
         int getDecimalType();
-        Monster() : Character() {};
+        Monster() : Character() { decimal_type = 0; monster_index = -1; attack_damage_roll = NULL; };
 };
 #endif
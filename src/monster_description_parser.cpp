@@ -1,109 +1,116 @@
 #include <iostream>
-#include <fstream>
 #include <string>
-#include "util.h"
+#include "description_scanner.h"
 #include "monster_description_parser.h"
 
-const string NAME_KEYWORD = "NAME";
-const string DESC_KEYWORD = "DESC";
-const string COLOR_KEYWORD = "COLOR";
-const string SPEED_KEYWORD = "SPEED";
-const string ABILITIES_KEYWORD = "ABIL";
-const string HITPOINTS_KEYWORD = "HP";
-const string ATTACK_DAMAGE_KEYWORD = "DAM";
-const string SYMBOL_KEYWORD = "SYMB";
-const string EXPERIENCE_KEYWORD = "XP";
+enum MonsterField {
+    MONSTER_NAME,
+    MONSTER_DESCRIPTION,
+    MONSTER_COLOR,
+    MONSTER_SPEED,
+    MONSTER_ABILITIES,
+    MONSTER_HITPOINTS,
+    MONSTER_ATTACK_DAMAGE,
+    MONSTER_SYMBOL,
+    MONSTER_EXPERIENCE,
+    MONSTER_END
+};
+
+static const KeywordEntry MONSTER_KEYWORDS[] = {
+    { "NAME", MONSTER_NAME },
+    { "DESC", MONSTER_DESCRIPTION },
+    { "COLOR", MONSTER_COLOR },
+    { "SPEED", MONSTER_SPEED },
+    { "ABIL", MONSTER_ABILITIES },
+    { "HP", MONSTER_HITPOINTS },
+    { "DAM", MONSTER_ATTACK_DAMAGE },
+    { "SYMB", MONSTER_SYMBOL },
+    { "XP", MONSTER_EXPERIENCE },
+    { "END", MONSTER_END }
+};
+
+static const int NUMBER_OF_MONSTER_KEYWORDS = sizeof(MONSTER_KEYWORDS) / sizeof(MONSTER_KEYWORDS[0]);
 
 MonsterDescriptionParser::MonsterDescriptionParser(string filepath) {
     this->filepath = filepath;
 }
 
+/*
+ * Parses one BEGIN MONSTER block. Returns false if the block raised an error or
+ * never reached a valid END, in which case the monster is skipped.
+ */
+static bool parse_monster_block(const Slice & block, MonsterTemplate & current_monster) {
+    DescriptionScanner scanner(block);
+    Slice line;
+    scanner.nextLine(line);
+    while (scanner.nextLine(line)) {
+        Slice value;
+        try {
+            switch (DescriptionScanner::lookupKeyword(MONSTER_KEYWORDS, NUMBER_OF_MONSTER_KEYWORDS, line, value)) {
+                case MONSTER_NAME:
+                    current_monster.setName(value.toString());
+                    break;
+                case MONSTER_DESCRIPTION:
+                    current_monster.setDescription(scanner.readDescription());
+                    break;
+                case MONSTER_COLOR:
+                    current_monster.setColors(DescriptionScanner::splitWords(value));
+                    break;
+                case MONSTER_SPEED:
+                    current_monster.setSpeed(DescriptionScanner::parseNumeric(value));
+                    break;
+                case MONSTER_ABILITIES:
+                    current_monster.setAbilities(DescriptionScanner::splitWords(value));
+                    break;
+                case MONSTER_HITPOINTS:
+                    current_monster.setHitpoints(DescriptionScanner::parseNumeric(value));
+                    break;
+                case MONSTER_ATTACK_DAMAGE:
+                    current_monster.setAttackDamage(DescriptionScanner::parseNumeric(value));
+                    break;
+                case MONSTER_SYMBOL:
+                    if (value.length) {
+                        current_monster.setSymbol(value.data[0]);
+                    }
+                    break;
+                case MONSTER_EXPERIENCE:
+                    current_monster.setExperience(DescriptionScanner::parseNumeric(value));
+                    break;
+                case MONSTER_END:
+                    return current_monster.isValid();
+                default:
+                    break;
+            }
+        }
+        catch(...) {
+            return false;
+        }
+    }
+    return false;
+}
+
 void MonsterDescriptionParser::parseFile() {
-    vector<MonsterTemplate> new_monsters;
-    MonsterTemplate * current_monster = NULL;
-    string line;
-    ifstream file;
-    file.open(filepath);
-    if (!file.is_open()) {
+    DescriptionScanner scanner;
+    if (!scanner.readFile(filepath)) {
         throw "Could not open file";
     }
-    getline(file, line);
-    if (line.compare("RLG327 MONSTER DESCRIPTION 1") != 0) {
+    Slice line;
+    if (!scanner.nextLine(line) || !line.equals("RLG327 MONSTER DESCRIPTION 1")) {
         throw "Invalid first line of file";
     }
-    bool exception_raised = false;
-    while (getline(file, line)) {
-        if (line.compare("BEGIN MONSTER") == 0) {
-            current_monster = new MonsterTemplate();
-            exception_raised = false;
-        }
-        else if (exception_raised) {
-            continue;
-        }
-        else {
-            try{
-                if (starts_with(line, NAME_KEYWORD)) {
-                    line.erase(0, (NAME_KEYWORD + " ").length());
-                    current_monster->setName(line);
-                }
-                else if(starts_with(line, DESC_KEYWORD)) {
-                    string description = "";
-                    while (getline(file, line) && line.compare(".") != 0) {
-                        if (line.length() > 77) {
-                            throw "Description line too long";
-                        }
-                        description += line.substr(0, 77) + "\n";
-                    }
-                    description.erase(description.end() - 1, description.end());
-                    current_monster->setDescription(description);
-                }
-                else if (starts_with(line, COLOR_KEYWORD)) {
-                    line.erase(0, (COLOR_KEYWORD + " ").length());
-                    current_monster->setColors(split(line, " "));
-                }
-                else if (starts_with(line, SPEED_KEYWORD)) {
-                    line.erase(0, (SPEED_KEYWORD + " ").length());
-                    Numeric * speed = new Numeric(line);
-                    current_monster->setSpeed(speed);
-                }
-                else if(starts_with(line, ABILITIES_KEYWORD)) {
-                    line.erase(0, (COLOR_KEYWORD + " ").length());
-                    current_monster->setAbilities(split(line, " "));
-                }
-                else if (starts_with(line, HITPOINTS_KEYWORD)) {
-                    line.erase(0, (HITPOINTS_KEYWORD + " ").length());
-                    Numeric * hp = new Numeric(line);
-                    current_monster->setHitpoints(hp);
-                }
-                else if (starts_with(line, ATTACK_DAMAGE_KEYWORD)) {
-                    line.erase(0, (ATTACK_DAMAGE_KEYWORD + " ").length());
-                    Numeric * attack = new Numeric(line);
-                    current_monster->setAttackDamage(attack);
-                }
-                else if (starts_with(line, SYMBOL_KEYWORD)) {
-                    line.erase(0, (SYMBOL_KEYWORD + " ").length());
-                    current_monster->setSymbol(line[0]);
-                }
-                else if (starts_with(line, EXPERIENCE_KEYWORD)) {
-                    line.erase(0, (EXPERIENCE_KEYWORD + " ").length());
-                    Numeric * xp = new Numeric(line);
-                    current_monster->setExperience(xp);
-                }
-                else if (line.compare("END") == 0) {
-                    if (current_monster->isValid()) {
-                        new_monsters.push_back(*current_monster);
-                    }
-                }
-
-            }
-            catch(...) {
-                exception_raised = true;
-            }
+    vector<Slice> blocks = scanner.splitBlocks("BEGIN MONSTER");
+    vector<MonsterTemplate> parsed_monsters(blocks.size());
+    vector<char> is_parsed(blocks.size());
+    for_each_block(blocks.size(), [&](size_t i) {
+        is_parsed[i] = parse_monster_block(blocks[i], parsed_monsters[i]);
+    });
+    vector<MonsterTemplate> new_monsters;
+    for (size_t i = 0; i < blocks.size(); i++) {
+        if (is_parsed[i]) {
+            new_monsters.push_back(parsed_monsters[i]);
         }
     }
     monster_templates = new_monsters;
-    file.close();
-
 }
 
 void MonsterDescriptionParser::printMonsters() {
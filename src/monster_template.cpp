@@ -4,8 +4,13 @@
 
 using namespace std;
 
-void MonsterTemplate :: setExperience(Numeric * xp) {
+Numeric MonsterTemplate :: getExperience() {
+    return experience;
+}
+
+void MonsterTemplate :: setExperience(Numeric xp) {
     experience = xp;
+    experience_roll = DiceDistribution(experience);
 }
 
 string MonsterTemplate::getName() {
@@ -13,7 +18,8 @@ string MonsterTemplate::getName() {
 }
 
 void MonsterTemplate::setName(string n) {
-    name = n;
+    name = move(n);
+    updateDetails();
 }
 
 string MonsterTemplate::getDescription() {
@@ -21,7 +27,8 @@ string MonsterTemplate::getDescription() {
 }
 
 void MonsterTemplate::setDescription(string d) {
-    description = d;
+    description = move(d);
+    updateDetails();
 }
 
 vector<string> MonsterTemplate::getColors() {
@@ -29,7 +36,8 @@ vector<string> MonsterTemplate::getColors() {
 }
 
 void MonsterTemplate::setColors(vector<string> c) {
-    colors = c;
+    colors = move(c);
+    updateDetails();
 }
 
 char MonsterTemplate::getSymbol() {
@@ -38,14 +46,16 @@ char MonsterTemplate::getSymbol() {
 
 void MonsterTemplate::setSymbol(char c) {
     symbol = c;
+    updateDetails();
 }
 
-Numeric * MonsterTemplate ::getSpeed() {
+Numeric MonsterTemplate ::getSpeed() {
     return speed;
 }
 
-void MonsterTemplate::setSpeed(Numeric * s) {
+void MonsterTemplate::setSpeed(Numeric s) {
     speed = s;
+    speed_roll = DiceDistribution(speed);
 }
 
 vector<string> MonsterTemplate::getAbilities() {
@@ -53,61 +63,74 @@ vector<string> MonsterTemplate::getAbilities() {
 }
 
 void MonsterTemplate::setAbilities(vector<string> a) {
-    abilities = a;
+    abilities = move(a);
+    updateDetails();
 }
 
-Numeric * MonsterTemplate::getHitpoints() {
+Numeric MonsterTemplate::getHitpoints() {
     return hitpoints;
 }
 
-void MonsterTemplate::setHitpoints(Numeric * h) {
+void MonsterTemplate::setHitpoints(Numeric h) {
     hitpoints = h;
+    hitpoints_roll = DiceDistribution(hitpoints);
 }
 
-Numeric * MonsterTemplate::getAttackDamage() {
+Numeric MonsterTemplate::getAttackDamage() {
     return attack_damage;
 }
 
 
-void MonsterTemplate::setAttackDamage(Numeric * a) {
+void MonsterTemplate::setAttackDamage(Numeric a) {
     attack_damage = a;
+    attack_damage_roll = DiceDistribution(attack_damage);
 }
 
 bool MonsterTemplate::isValid() {
-    return !name.empty() && !description.empty() && colors.size() > 0 && speed->isValid() \
-          && abilities.size() > 0 && hitpoints->isValid() && attack_damage->isValid() \
-          && symbol;
+    return !name.empty() && !description.empty() && colors.size() > 0 && speed.isValid() \
+          && abilities.size() > 0 && hitpoints.isValid() && attack_damage.isValid() \
+          && experience.isValid() && symbol;
 }
 
 string MonsterTemplate::toString() {
     return name + "\n" + description + "\n" + symbol + "\n" + vector_to_string(colors)\
-           + "\n" + speed->toString() + "\n" + hitpoints->toString()\
-           + "\n" + attack_damage->toString();
+           + "\n" + speed.toString() + "\n" + hitpoints.toString()\
+           + "\n" + attack_damage.toString();
+}
+
+void MonsterTemplate::updateDetails() {
+    MonsterDetails * new_details = new MonsterDetails();
+    new_details->name = name;
+    new_details->description = description;
+    new_details->color = colors.size() ? colors[0] : "";
+    new_details->symbol = symbol;
+    new_details->abilities = abilities;
+    details.reset(new_details);
 }
 
-Monster * MonsterTemplate::makeMonster() {
-    Monster * m = new Monster();
+Monster * MonsterTemplate::makeMonster(EntityPool<Monster> & pool) {
+    Monster * m = pool.create();
     m->last_known_player_x = 0;
     m->last_known_player_y = 0;
-    m->name = name;
-    m->description = description;
-    m->color = colors[0];
-    m->symbol = symbol;
-    m->speed = speed->roll();
-    m->abilities = abilities;
-    m->hitpoints = hitpoints->roll();
+    m->details = details;
+    DiceRandom & random = thread_dice_random();
+    m->speed = speed_roll.roll(random);
+    m->hitpoints = hitpoints_roll.roll(random);
     m->max_hitpoints = m->hitpoints;
-    m->decimal_type = 0;
+    m->updateDecimalType();
     m->attack_damage = attack_damage;
-    m->experience = experience->roll();
+    m->attack_damage_roll = &attack_damage_roll;
+    m->experience = experience_roll.roll(random);
     return m;
 }
 
 MonsterTemplate::MonsterTemplate() {
     name = "";
     description = "";
+    symbol = 0;
     colors.clear();
     abilities.clear();
+    updateDetails();
 }
 
 MonsterTemplate :: ~MonsterTemplate() {
@@ -5,6 +5,8 @@
 #include <vector>
 #include "monster.h"
 #include "numeric.h"
+#include "dice_distribution.h"
+#include "entity_pool.h"
 
 using namespace std;
 
@@ -14,16 +16,26 @@ class MonsterTemplate {
         string description;
         vector<string> colors;
         char symbol;
-        Numeric * speed;
+        Numeric speed;
         vector<string> abilities;
-        Numeric * hitpoints;
-        Numeric * attack_damage;
-        Numeric * experience;
+        Numeric hitpoints;
+        Numeric attack_damage;
+        Numeric experience;
+        // Compiled by the setters of the fields rolled per monster
+        DiceDistribution speed_roll;
+        DiceDistribution hitpoints_roll;
+        DiceDistribution attack_damage_roll;
+        DiceDistribution experience_roll;
+        // Shared by every monster made from the template. Rebuilt by the
+        // setters of the fields it holds.
+        shared_ptr<const MonsterDetails> details;
+        void updateDetails();
 
     public:
-        Monster * makeMonster();
+        Monster * makeMonster(EntityPool<Monster> & pool);
         bool isValid();
-        void setExperience(Numeric *);
+        Numeric getExperience();
+        void setExperience(Numeric);
         string getName();
         void setName(string);
         string getDescription();
@@ -32,14 +44,14 @@ class MonsterTemplate {
         void setColors(vector<string>);
         char getSymbol();
         void setSymbol(char c);
-        Numeric * getSpeed();
-        void setSpeed(Numeric *);
+        Numeric getSpeed();
+        void setSpeed(Numeric);
         vector<string> getAbilities();
         void setAbilities(vector<string>);
-        Numeric * getHitpoints();
-        void setHitpoints(Numeric *);
-        Numeric * getAttackDamage();
-        void setAttackDamage(Numeric *);
+        Numeric getHitpoints();
+        void setHitpoints(Numeric);
+        Numeric getAttackDamage();
+        void setAttackDamage(Numeric);
         string toString();
         ~MonsterTemplate();
         MonsterTemplate();
@@ -1,8 +1,11 @@
 #include <string>
 #include <vector>
+#include <map>
+#include <tuple>
 #include <cstdlib>
 #include "util.h"
 #include "numeric.h"
+#include "dice_distribution.h"
 
 using namespace std;
 
@@ -29,21 +32,56 @@ Numeric :: Numeric(string numericString) {
     }
 }
 
+Numeric :: Numeric(int base, int dice, int sides) {
+    this->base = base;
+    this->dice = dice;
+    this->sides = sides;
+}
+
 Numeric :: Numeric() {
     base = -1000;
     dice = -1000;
     sides = -1000;
 }
 
-bool Numeric :: isValid() {
+bool Numeric :: isValid() const {
     return base != -1000 && dice != -1000 && sides != -1000;
 }
 
-int Numeric :: roll() {
-    return random_int(base + dice, base + (dice * sides));
+/*
+ * Rolls each die, so the total follows the real NdS distribution rather than
+ * a flat range.
+ */
+int Numeric :: roll() const {
+    DiceRandom & random = thread_dice_random();
+    int total = base;
+    if (sides > 0) {
+        for (int i = 0; i < dice; i++) {
+            total += 1 + random.uniform(sides);
+        }
+    }
+    return total;
+}
+
+/*
+ * Fills out with n rolls from a compiled table. Numeric holds no table, so
+ * each thread keeps up to MAX_CACHED_DISTRIBUTIONS of them keyed by the dice
+ * and repeated batches of the same dice compile it once.
+ */
+void Numeric :: roll(int n, int * out) const {
+    static thread_local map<tuple<int, int, int>, DiceDistribution> distributions;
+    tuple<int, int, int> key(base, dice, sides);
+    map<tuple<int, int, int>, DiceDistribution>::iterator found = distributions.find(key);
+    if (found == distributions.end()) {
+        if (distributions.size() >= MAX_CACHED_DISTRIBUTIONS) {
+            distributions.clear();
+        }
+        found = distributions.insert(make_pair(key, DiceDistribution(*this))).first;
+    }
+    found->second.roll(n, out, thread_dice_random());
 }
 
-string Numeric :: toString() {
+string Numeric :: toString() const {
     return to_string(base) + "+" + to_string(dice) + "d" + to_string(sides);
 }
 
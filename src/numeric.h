@@ -2,20 +2,28 @@
 #define NUMERIC_H
 #include <vector>
 #include <string>
+#include <type_traits>
 
 using namespace std;
 
+/*
+ * A dice value of the form <base>+<dice>d<sides>. It is a plain value that
+ * templates, objects and characters embed and copy, never a shared pointer.
+ */
 class Numeric {
     public:
         int base;
         int dice;
         int sides;
-        string toString();
-        bool isValid();
-        int roll();
+        string toString() const;
+        bool isValid() const;
+        int roll() const;
+        void roll(int n, int * out) const;
         Numeric(string);
+        Numeric(int base, int dice, int sides);
         Numeric();
-        ~Numeric() {};
 };
 
+static_assert(is_trivially_copyable<Numeric>::value, "Numeric must stay a plain value");
+
 #endif
@@ -1,62 +1,14 @@
 #include "object.h"
 
-char Object :: getSymbol() {
-    if (!type.compare("WEAPON")) {
-        return '|';
-    }
-    if (!type.compare("OFFHAND")) {
-        return ')';
-    }
-    if (!type.compare("RANGED")) {
-        return '}';
-    }
-    if (!type.compare("ARMOR")) {
-        return '[';
-    }
-    if (!type.compare("HELMET")) {
-        return ']';
-    }
-    if (!type.compare("CLOAK")) {
-        return '(';
-    }
-    if (!type.compare("GLOVES")) {
-        return '{';
-    }
-    if (!type.compare("BOOTS")) {
-        return '\\';
-    }
-    if (!type.compare("RING")) {
-        return '=';
-    }
-    if (!type.compare("AMULET")) {
-        return '"';
-    }
-    if (!type.compare("LIGHT")) {
-        return '_';
+ObjectType parseObjectType(const string & type) {
+    for (int i = 0; i < OBJECT_UNKNOWN; i++) {
+        if (!type.compare(OBJECT_TYPE_NAMES[i])) {
+            return (ObjectType) i;
+        }
     }
-    if (!type.compare("SCROLL")) {
-        return '~';
-    }
-    if (!type.compare("BOOK")) {
-        return '?';
-    }
-    if (!type.compare("FLASK")) {
-        return '!';
-    }
-    if (!type.compare("GOLD")) {
-        return '$';
-    }
-    if (!type.compare("AMMUNITION")) {
-        return '/';
-    }
-    if (!type.compare("FOOD")) {
-        return ',';
-    }
-    if (!type.compare("SPELL")) {
-        return '*';
-    }
-    if (!type.compare("CONTAINER")) {
-        return '%';
-    }
-    return '*';
+    return OBJECT_UNKNOWN;
+}
+
+char Object :: getSymbol() {
+    return OBJECT_TYPE_SYMBOLS[object_type];
 }
@@ -4,15 +4,53 @@
 #include "numeric.h"
 #include "board_element.h"
 
+enum ObjectType {
+    OBJECT_WEAPON,
+    OBJECT_OFFHAND,
+    OBJECT_RANGED,
+    OBJECT_ARMOR,
+    OBJECT_HELMET,
+    OBJECT_CLOAK,
+    OBJECT_GLOVES,
+    OBJECT_BOOTS,
+    OBJECT_AMULET,
+    OBJECT_LIGHT,
+    OBJECT_RING,
+    OBJECT_SCROLL,
+    OBJECT_BOOK,
+    OBJECT_FLASK,
+    OBJECT_GOLD,
+    OBJECT_AMMUNITION,
+    OBJECT_FOOD,
+    OBJECT_SPELL,
+    OBJECT_CONTAINER,
+    OBJECT_UNKNOWN,
+    NUMBER_OF_OBJECT_TYPES
+};
+
+static constexpr const char * OBJECT_TYPE_NAMES[NUMBER_OF_OBJECT_TYPES] = {
+    "WEAPON", "OFFHAND", "RANGED", "ARMOR", "HELMET", "CLOAK", "GLOVES",
+    "BOOTS", "AMULET", "LIGHT", "RING", "SCROLL", "BOOK", "FLASK", "GOLD",
+    "AMMUNITION", "FOOD", "SPELL", "CONTAINER", ""
+};
+
+static constexpr char OBJECT_TYPE_SYMBOLS[NUMBER_OF_OBJECT_TYPES] = {
+    '|', ')', '}', '[', ']', '(', '{', '\\', '"', '_', '=', '~', '?', '!',
+    '$', '/', ',', '*', '%', '*'
+};
+
+ObjectType parseObjectType(const string & type);
+
 class Object : public BoardElement {
     public:
         char getSymbol();
         string name;
         string description;
         string type;
+        ObjectType object_type;
         string color;
         int hit_bonus;
-        Numeric * damage_bonus;
+        Numeric damage_bonus;
         int dodge_bonus;
         int defense_bonus;
         int weight;
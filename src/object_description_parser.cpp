@@ -1,130 +1,139 @@
 #include <iostream>
-#include <fstream>
 #include <string>
-#include "util.h"
+#include "description_scanner.h"
 #include "object_description_parser.h"
 
-const string NAME_KEYWORD = "NAME";
-const string DESC_KEYWORD = "DESC";
-const string TYPE_KEYWORD = "TYPE";
-const string COLOR_KEYWORD = "COLOR";
-const string HIT_BONUS_KEYWORD = "HIT";
-const string DAMAGE_BONUS_KEYWORD = "DAM";
-const string DODGE_BONUS_KEYWORD = "DODGE";
-const string DEFENSE_BONUS_KEYWORD = "DEF";
-const string WEIGHT_KEYWORD = "WEIGHT";
-const string SPEED_BONUS_KEYWORD = "SPEED";
-const string SPECIAL_ATTRIBUTE_KEYWORD = "ATTR";
-const string VALUE_KEYWORD = "VAL";
-const string COST_KEYWORD = "COST";
+enum ObjectField {
+    OBJECT_NAME,
+    OBJECT_DESCRIPTION,
+    OBJECT_TYPE,
+    OBJECT_COLOR,
+    OBJECT_HIT_BONUS,
+    OBJECT_DAMAGE_BONUS,
+    OBJECT_DODGE_BONUS,
+    OBJECT_DEFENSE_BONUS,
+    OBJECT_WEIGHT,
+    OBJECT_SPEED_BONUS,
+    OBJECT_SPECIAL_ATTRIBUTE,
+    OBJECT_VALUE,
+    OBJECT_COST,
+    OBJECT_END
+};
+
+static const KeywordEntry OBJECT_KEYWORDS[] = {
+    { "NAME", OBJECT_NAME },
+    { "DESC", OBJECT_DESCRIPTION },
+    { "TYPE", OBJECT_TYPE },
+    { "COLOR", OBJECT_COLOR },
+    { "HIT", OBJECT_HIT_BONUS },
+    { "DAM", OBJECT_DAMAGE_BONUS },
+    { "DODGE", OBJECT_DODGE_BONUS },
+    { "DEF", OBJECT_DEFENSE_BONUS },
+    { "WEIGHT", OBJECT_WEIGHT },
+    { "SPEED", OBJECT_SPEED_BONUS },
+    { "ATTR", OBJECT_SPECIAL_ATTRIBUTE },
+    { "VAL", OBJECT_VALUE },
+    { "COST", OBJECT_COST },
+    { "END", OBJECT_END }
+};
+
+static const int NUMBER_OF_OBJECT_KEYWORDS = sizeof(OBJECT_KEYWORDS) / sizeof(OBJECT_KEYWORDS[0]);
 
 ObjectDescriptionParser::ObjectDescriptionParser(string filepath) {
     this->filepath = filepath;
 }
 
+/*
+ * Parses one BEGIN OBJECT block. Returns false if the block raised an error or
+ * never reached a valid END, in which case the object is skipped.
+ */
+static bool parse_object_block(const Slice & block, ObjectTemplate & current_object) {
+    DescriptionScanner scanner(block);
+    Slice line;
+    scanner.nextLine(line);
+    while (scanner.nextLine(line)) {
+        Slice value;
+        try {
+            switch (DescriptionScanner::lookupKeyword(OBJECT_KEYWORDS, NUMBER_OF_OBJECT_KEYWORDS, line, value)) {
+                case OBJECT_NAME:
+                    current_object.name = value.toString();
+                    break;
+                case OBJECT_DESCRIPTION:
+                    current_object.description = scanner.readDescription();
+                    break;
+                case OBJECT_TYPE:
+                    current_object.type = value.toString();
+                    current_object.object_type = parseObjectType(current_object.type);
+                    break;
+                case OBJECT_COLOR:
+                    current_object.color = value.toString();
+                    break;
+                case OBJECT_HIT_BONUS:
+                    current_object.hit_bonus = DescriptionScanner::parseNumeric(value);
+                    break;
+                case OBJECT_DAMAGE_BONUS:
+                    current_object.damage_bonus = DescriptionScanner::parseNumeric(value);
+                    break;
+                case OBJECT_DODGE_BONUS:
+                    current_object.dodge_bonus = DescriptionScanner::parseNumeric(value);
+                    break;
+                case OBJECT_DEFENSE_BONUS:
+                    current_object.defense_bonus = DescriptionScanner::parseNumeric(value);
+                    break;
+                case OBJECT_WEIGHT:
+                    current_object.weight = DescriptionScanner::parseNumeric(value);
+                    break;
+                case OBJECT_SPEED_BONUS:
+                    current_object.speed_bonus = DescriptionScanner::parseNumeric(value);
+                    break;
+                case OBJECT_SPECIAL_ATTRIBUTE:
+                    current_object.special_attribute = DescriptionScanner::parseNumeric(value);
+                    break;
+                case OBJECT_VALUE:
+                    current_object.value = DescriptionScanner::parseNumeric(value);
+                    break;
+                case OBJECT_COST:
+                    current_object.cost = DescriptionScanner::parseNumeric(value);
+                    break;
+                case OBJECT_END:
+                    if (!current_object.isValid()) {
+                        throw "An object with an invalid configuration was parsed";
+                    }
+                    current_object.compileRolls();
+                    return true;
+                default:
+                    break;
+            }
+        }
+        catch(...) {
+            return false;
+        }
+    }
+    return false;
+}
+
 void ObjectDescriptionParser::parseFile() {
-    fflush(stdout);
-    vector<ObjectTemplate> new_objects;
-    ObjectTemplate * current_object = NULL;
-    string line;
-    ifstream file;
-    file.open(filepath);
-    if (!file.is_open()) {
+    DescriptionScanner scanner;
+    if (!scanner.readFile(filepath)) {
         throw "Could not open file";
     }
-    getline(file, line);
-    if (line.compare("RLG327 OBJECT DESCRIPTION 1") != 0) {
+    Slice line;
+    if (!scanner.nextLine(line) || !line.equals("RLG327 OBJECT DESCRIPTION 1")) {
         throw "Invalid first line of file";
     }
-    bool exception_raised = false;
-    while (getline(file, line)) {
-        if (line.compare("BEGIN OBJECT") == 0) {
-            current_object = new ObjectTemplate();
-            exception_raised = false;
-        }
-        else if (exception_raised) {
-            continue;
-        }
-        else {
-            try{
-                if (starts_with(line, NAME_KEYWORD)) {
-                    line.erase(0, (NAME_KEYWORD + " ").length());
-                    current_object->name = line;
-                }
-                else if(starts_with(line, DESC_KEYWORD)) {
-                    string description = "";
-                    while (getline(file, line) && line.compare(".") != 0) {
-                        if (line.length() > 77) {
-                            throw "Description line too long";
-                        }
-                        description += line.substr(0, 77) + "\n";
-                    }
-                    description.erase(description.end() - 1, description.end());
-                    current_object->description = description;
-                }
-                else if (starts_with(line, TYPE_KEYWORD)) {
-                    line.erase(0, (TYPE_KEYWORD + " ").length());
-                    current_object->type = line;
-                }
-                else if (starts_with(line, COLOR_KEYWORD)) {
-                    line.erase(0, (COLOR_KEYWORD + " ").length());
-                    current_object->color = line;
-                }
-                else if (starts_with(line, HIT_BONUS_KEYWORD)) {
-                    line.erase(0, (HIT_BONUS_KEYWORD + " ").length());
-                    current_object->hit_bonus = new Numeric(line);
-                }
-                else if (starts_with(line, DAMAGE_BONUS_KEYWORD)) {
-                    line.erase(0, (DAMAGE_BONUS_KEYWORD + " ").length());
-                    current_object->damage_bonus = new Numeric(line);
-                }
-                else if (starts_with(line, DODGE_BONUS_KEYWORD)) {
-                    line.erase(0, (DODGE_BONUS_KEYWORD + " ").length());
-                    current_object->dodge_bonus = new Numeric(line);
-                }
-                else if (starts_with(line, DEFENSE_BONUS_KEYWORD)) {
-                    line.erase(0, DEFENSE_BONUS_KEYWORD.length() + 1);
-                    current_object->defense_bonus = new Numeric(line);
-                }
-                else if(starts_with(line, WEIGHT_KEYWORD)) {
-                    line.erase(0, WEIGHT_KEYWORD.length() + 1);
-                    current_object->weight = new Numeric(line);
-                }
-                else if(starts_with(line, SPECIAL_ATTRIBUTE_KEYWORD)) {
-                    line.erase(0, SPECIAL_ATTRIBUTE_KEYWORD.length() + 1);
-                    current_object->special_attribute = new Numeric(line);
-                }
-                else if (starts_with(line, VALUE_KEYWORD)) {
-                    line.erase(0, VALUE_KEYWORD.length() + 1);
-                    current_object->value = new Numeric(line);
-                }
-                else if (starts_with(line, SPEED_BONUS_KEYWORD)) {
-                    line.erase(0, (SPEED_BONUS_KEYWORD + " ").length());
-                    Numeric * speed = new Numeric(line);
-                    current_object->speed_bonus = speed;
-                }
-                else if (starts_with(line, COST_KEYWORD)) {
-                    line.erase(0, (COST_KEYWORD + " ").length());
-                    Numeric * cost = new Numeric(line);
-                    current_object->cost = cost;
-                }
-                else if (line.compare("END") == 0) {
-                    if (current_object->isValid()) {
-                        new_objects.push_back(*current_object);
-                    }
-                    else {
-                        throw "An object with an invalid configuration was parsed";
-                    }
-                }
-
-            }
-            catch(...) {
-                exception_raised = true;
-            }
+    vector<Slice> blocks = scanner.splitBlocks("BEGIN OBJECT");
+    vector<ObjectTemplate> parsed_objects(blocks.size());
+    vector<char> is_parsed(blocks.size());
+    for_each_block(blocks.size(), [&](size_t i) {
+        is_parsed[i] = parse_object_block(blocks[i], parsed_objects[i]);
+    });
+    vector<ObjectTemplate> new_objects;
+    for (size_t i = 0; i < blocks.size(); i++) {
+        if (is_parsed[i]) {
+            new_objects.push_back(parsed_objects[i]);
         }
     }
     object_templates = new_objects;
-    file.close();
 }
 
 void ObjectDescriptionParser::printObjects() {
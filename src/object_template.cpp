@@ -5,50 +5,79 @@
         string description;
         string type;
         string color;
-        Numeric * hit_bonus;
-        Numeric * damage_bonus;
-        Numeric * dodge_bonus;
-        Numeric * defense_bonus;
-        Numeric * weight;
-        Numeric * speed_bonus;
-        Numeric * special_attribute;
-        Numeric * value;
+        Numeric hit_bonus;
+        Numeric damage_bonus;
+        Numeric dodge_bonus;
+        Numeric defense_bonus;
+        Numeric weight;
+        Numeric speed_bonus;
+        Numeric special_attribute;
+        Numeric value;
  *
  */
 
 Object * ObjectTemplate :: makeObject() {
     Object * object = new Object();
+    initializeObject(object);
+    return object;
+}
+
+Object * ObjectTemplate :: makeObject(EntityPool<Object> & pool) {
+    Object * object = pool.create();
+    initializeObject(object);
+    return object;
+}
+
+/*
+ * Compiles the dice of every field rolled per object. Must be called once the
+ * template is filled in and again if any of those fields change.
+ */
+void ObjectTemplate :: compileRolls() {
+    hit_bonus_roll = DiceDistribution(hit_bonus);
+    dodge_bonus_roll = DiceDistribution(dodge_bonus);
+    defense_bonus_roll = DiceDistribution(defense_bonus);
+    weight_roll = DiceDistribution(weight);
+    speed_bonus_roll = DiceDistribution(speed_bonus);
+    special_attribute_roll = DiceDistribution(special_attribute);
+    value_roll = DiceDistribution(value);
+    cost_roll = DiceDistribution(cost);
+    rolls_compiled = true;
+}
+
+void ObjectTemplate :: initializeObject(Object * object) {
+    if (!rolls_compiled) {
+        throw "Object template rolls are not compiled";
+    }
+    DiceRandom & random = thread_dice_random();
     object->name = name;
     object->description = description;
     object->type = type;
+    object->object_type = object_type;
     object->color = color;
-    object->hit_bonus = hit_bonus->roll();
+    object->hit_bonus = hit_bonus_roll.roll(random);
     object->damage_bonus = damage_bonus;
-    object->dodge_bonus = dodge_bonus->roll();
-    object->defense_bonus = defense_bonus->roll();
-    object->weight = weight->roll();
-    object->speed_bonus = speed_bonus->roll();
-    object->special_attribute = special_attribute->roll();
-    object->value = value->roll();
-    object->cost = cost->roll();
-    return object;
+    object->dodge_bonus = dodge_bonus_roll.roll(random);
+    object->defense_bonus = defense_bonus_roll.roll(random);
+    object->weight = weight_roll.roll(random);
+    object->speed_bonus = speed_bonus_roll.roll(random);
+    object->special_attribute = special_attribute_roll.roll(random);
+    object->value = value_roll.roll(random);
+    object->cost = cost_roll.roll(random);
 }
 
 bool ObjectTemplate :: isValid() {
     return name.size() > 0 && description.size() > 0 && type.size() > 0 &&\
-        color.size() > 0 && hit_bonus && hit_bonus->isValid() && damage_bonus &&\
-        damage_bonus->isValid() && dodge_bonus && dodge_bonus->isValid() &&\
-        defense_bonus && defense_bonus->isValid() && weight && weight->isValid() &&\
-        speed_bonus && speed_bonus->isValid() && special_attribute &&\
-        special_attribute->isValid() && value && value->isValid() &&\
-        cost && cost->isValid();
+        color.size() > 0 && hit_bonus.isValid() && damage_bonus.isValid() &&\
+        dodge_bonus.isValid() && defense_bonus.isValid() && weight.isValid() &&\
+        speed_bonus.isValid() && special_attribute.isValid() && value.isValid() &&\
+        cost.isValid();
 }
 
 string ObjectTemplate :: toString() {
     return name + "\n" + description + "\n" + type + "\n" + color\
-           + "\n" + weight->toString() + "\n" + dodge_bonus->toString()\
-           + "\n" + damage_bonus->toString() + "\n" + defense_bonus->toString()\
-           + "\n" + speed_bonus->toString() + "\n" + hit_bonus->toString()\
-           + "\n" + special_attribute->toString() + "\n" + value->toString();
+           + "\n" + weight.toString() + "\n" + dodge_bonus.toString()\
+           + "\n" + damage_bonus.toString() + "\n" + defense_bonus.toString()\
+           + "\n" + speed_bonus.toString() + "\n" + hit_bonus.toString()\
+           + "\n" + special_attribute.toString() + "\n" + value.toString();
 
 }
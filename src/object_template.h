@@ -1,25 +1,44 @@
 #ifndef OBJECT_TEMPLATE_H
 #define OBJECT_TEMPLATE_H
 #include "numeric.h"
+#include "dice_distribution.h"
 #include "object.h"
+#include "entity_pool.h"
 
 class ObjectTemplate {
+    private:
+        // The rolled fields compiled by compileRolls
+        bool rolls_compiled;
+        DiceDistribution hit_bonus_roll;
+        DiceDistribution dodge_bonus_roll;
+        DiceDistribution defense_bonus_roll;
+        DiceDistribution weight_roll;
+        DiceDistribution speed_bonus_roll;
+        DiceDistribution special_attribute_roll;
+        DiceDistribution value_roll;
+        DiceDistribution cost_roll;
+        void initializeObject(Object * object);
+
     public:
+        void compileRolls();
         Object * makeObject();
+        Object * makeObject(EntityPool<Object> & pool);
         bool isValid();
         string toString();
         string name;
         string description;
         string type;
+        ObjectType object_type;
         string color;
-        Numeric * hit_bonus;
-        Numeric * damage_bonus;
-        Numeric * dodge_bonus;
-        Numeric * defense_bonus;
-        Numeric * weight;
-        Numeric * speed_bonus;
-        Numeric * special_attribute;
-        Numeric * value;
-        Numeric * cost;
+        Numeric hit_bonus;
+        Numeric damage_bonus;
+        Numeric dodge_bonus;
+        Numeric defense_bonus;
+        Numeric weight;
+        Numeric speed_bonus;
+        Numeric special_attribute;
+        Numeric value;
+        Numeric cost;
+        ObjectTemplate() : rolls_compiled(false) {};
 };
 #endif
@@ -8,11 +8,7 @@ void Player :: restoreHealth(int amount) {
 }
 
 void Player :: reduceMagicFromSpell(int amount) {
-    int bonus = 0;
-    if (intelligence_level) {
-        bonus = intelligence_level + ceil(pow(intelligence_level + 1, 1.5));
-    }
-    amount -= bonus;
+    amount -= intelligence_bonus;
     magic = max(0, magic - amount);
 
 }
@@ -24,20 +20,12 @@ void Player :: regenerateMagic(int turn) {
 }
 
 bool Player :: hasEnoughMagicForSpell(int cost) {
-    int bonus = 0;
-    if (intelligence_level) {
-        bonus = intelligence_level + ceil(pow(intelligence_level + 1, 1.5));
-    }
-    return (cost - bonus) <= magic;
+    return (cost - intelligence_bonus) <= magic;
 }
 
 int Player :: getDamageForSpell(Object * spell) {
-    int damage = spell->damage_bonus->roll();
-    int bonus = 0;
-    if (intelligence_level) {
-        bonus = intelligence_level + ceil(pow(intelligence_level + 1, 1.5));
-    }
-    return damage + bonus;
+    int damage = spell->damage_bonus.roll();
+    return damage + intelligence_bonus;
 }
 
 void Player :: regenerateStamina(int turn) {
@@ -47,68 +35,34 @@ void Player :: regenerateStamina(int turn) {
 }
 
 bool Player :: hasEnoughStaminaForAttack(int cost) {
-    int bonus = 0;
-    if (dexterity_level) {
-        bonus = dexterity_level + ceil(pow(dexterity_level + 1, 1.5));
-    }
-    return (cost - bonus) <= stamina_points;
+    return (cost - dexterity_bonus) <= stamina_points;
 }
 
 void Player :: reduceStaminaFromDamage(int amount) {
     int actual_amount = ceil(amount * 0.7);
-    int bonus = 0;
-    if (dexterity_level) {
-        bonus = dexterity_level + ceil(pow(dexterity_level + 1, 1.5));
-    }
-    actual_amount -= bonus;
+    actual_amount -= dexterity_bonus;
     stamina_points = max(0, stamina_points - actual_amount);
 }
 
 bool Player :: hitWillConnect() {
-    int bonus = 0;
-    for (int i = 0; i < equipment.size(); i++) {
-        Object * item = equipment[i];
-        if (item) {
-            bonus += item->hit_bonus;
-        }
-    }
-    int chance = min(70 + bonus, 100);
+    int chance = min(70 + hit_bonus, 100);
     return random_int(1, 100) <= chance;
 }
 
 int Player :: getDefense() {
-    int defense = 0;
-    for (int i = 0; i < equipment.size(); i++) {
-        Object * item = equipment[i];
-        if (item) {
-            defense += item->defense_bonus;
-        }
-    }
     int bonus = 0;
     if  (strength_level) {
-        bonus = random_int(0, strength_level + ceil(pow(strength_level + 1, 1.5)));
+        bonus = random_int(0, max_strength_defense_bonus);
     }
-    return bonus + defense;
+    return bonus + equipment_defense;
 }
 
 bool Player :: willDodgeAttack() {
-    int summed_chance = 0;
-    for (int i = 0; i < equipment.size(); i++) {
-        Object * object = equipment[i];
-        if (object) {
-            summed_chance += object->dodge_bonus;
-        }
-    }
-    int bonus = 0;
-    if (dexterity_level) {
-        bonus = ceil(pow(dexterity_level + 1, 1.5));
-    }
-    int chance = 1 + summed_chance + bonus;
-    return random_int(1, 100) <= chance;
+    return random_int(1, 100) <= dodge_chance;
 }
 
 int Player :: getMaxCarryWeight() {
-    return DEFAULT_MAX_CARRYING_WEIGHT + ceil(strength_level * 50);
+    return max_carry_weight;
 }
 
 void Player :: levelUpSkill(string skill) {
@@ -132,6 +86,7 @@ void Player :: levelUpSkill(string skill) {
     stamina_points = max_stamina_points;
     magic = max_magic;
     skill_points --;
+    updateDerivedStats();
 }
 
 void Player :: addExperience(int xp) {
@@ -152,35 +107,77 @@ int Player :: getExperienceRequiredForNextLevel() {
 }
 
 int Player :: getLightRadius() {
-    int bonus = 0;
-    if (intelligence_level) {
-        bonus = ceil(pow(intelligence_level + 1, 1.5));
-    }
-    int radius = DEFAULT_LIGHT_RADIUS + bonus;
-    int index = getIndexOfEquipmentType("LIGHT")[0];
-    Object * light_item = equipment[index];
-    if (light_item) {
-        radius += light_item->special_attribute;
-    }
-    return radius;
+    return light_radius;
 }
 
 int Player :: getSpeed() {
-    int bonus = 0;
-    if (dexterity_level) {
-        bonus = ceil(pow(dexterity_level + 1, 1.8));
-    }
-    int my_speed = speed + bonus;
+    return total_speed;
+}
+
+/*
+ * Recomputes every stat derived from equipment, inventory and skill levels.
+ * Must be called by anything that changes one of those.
+ */
+void Player :: updateDerivedStats() {
+    int equipment_weight = 0;
+    int speed_bonus = 0;
+    equipment_defense = 0;
+    hit_bonus = 0;
+    int dodge_bonus = 0;
     for (size_t i = 0; i < equipment.size(); i++) {
         Object * object = equipment[i];
         if (object) {
-            my_speed += object->speed_bonus;
+            equipment_weight += object->weight;
+            speed_bonus += object->speed_bonus;
+            equipment_defense += object->defense_bonus;
+            hit_bonus += object->hit_bonus;
+            dodge_bonus += object->dodge_bonus;
         }
     }
+    int inventory_weight = 0;
+    for (size_t i = 0; i < inventory.size(); i++) {
+        inventory_weight += inventory[i]->weight;
+    }
+    weight = equipment_weight + inventory_weight;
+    max_carry_weight = DEFAULT_MAX_CARRYING_WEIGHT + ceil(strength_level * 50);
+
+    max_strength_defense_bonus = 0;
+    if (strength_level) {
+        max_strength_defense_bonus = strength_level + ceil(pow(strength_level + 1, 1.5));
+    }
+    dexterity_bonus = 0;
+    dodge_chance = 1 + dodge_bonus;
+    total_speed = speed + speed_bonus;
+    if (dexterity_level) {
+        dexterity_bonus = dexterity_level + ceil(pow(dexterity_level + 1, 1.5));
+        dodge_chance += ceil(pow(dexterity_level + 1, 1.5));
+        total_speed += ceil(pow(dexterity_level + 1, 1.8));
+    }
     if (isOverEncumbered()) {
-        my_speed = my_speed / 4;
+        total_speed = total_speed / 4;
     }
-    return my_speed;
+    intelligence_bonus = 0;
+    light_radius = DEFAULT_LIGHT_RADIUS;
+    if (intelligence_level) {
+        intelligence_bonus = intelligence_level + ceil(pow(intelligence_level + 1, 1.5));
+        light_radius += ceil(pow(intelligence_level + 1, 1.5));
+    }
+    Object * light_item = equipment[SLOT_LIGHT];
+    if (light_item) {
+        light_radius += light_item->special_attribute;
+    }
+    // The weapon's damage (or bare hands') and the damage bonus of the rest
+    // of the melee equipment, compiled once rather than on every attack
+    attack_damage_rolls.clear();
+    Object * weapon = equipment[SLOT_WEAPON];
+    attack_damage_rolls.push_back(DiceDistribution(weapon ? weapon->damage_bonus : attack_damage));
+    for (size_t i = 1; i < equipment.size(); i++) {
+        Object * object = equipment[i];
+        if (object && i != SLOT_RANGED) {
+            attack_damage_rolls.push_back(DiceDistribution(object->damage_bonus));
+        }
+    }
+    attack_damage_bonus = ceil(strength_level * 5);
 }
 
 string Player :: getHudInfo() {
@@ -194,76 +191,29 @@ string Player :: getHudInfo() {
     return info;
 }
 
-string Player :: getStatusProgressBar(float base_percentage) {
-    string str = "|";
-    int percentage = base_percentage * 30;
-    for (int i = 1; i <= 30; i++) {
-        if (i <= percentage) {
-            str += "#";
-        }
-        else {
-            str += " ";
-        }
-    }
-    return str + "|";
-}
-
 bool Player :: isOverEncumbered() {
-    return getWeight() > getMaxCarryWeight();
-}
-
-int Player :: getEquipmentWeight() {
-    int weight = 0;
-    for (size_t i = 0; i < equipment.size(); i++) {
-        Object * object = equipment[i];
-        if (object) {
-            weight += object->weight;
-        }
-    }
-    return weight;
-}
-
-int Player :: getInventoryWeight() {
-    int weight = 0;
-    for (size_t i = 0; i < inventory.size(); i++) {
-        Object * object = inventory[i];
-        weight += object->weight;
-    }
-    return weight;
+    return weight > max_carry_weight;
 }
 
 int Player :: getWeight() {
-    return getEquipmentWeight() + getInventoryWeight();
+    return weight;
 }
 
 int Player :: getAttackDamage() {
-    Numeric * dice = attack_damage;
-    if (equipment[0]) {
-        dice = equipment[0]->damage_bonus;
-    }
-    int damage = dice->roll();
-
-    int bonus = 0;
-    if  (strength_level) {
-        bonus = strength_level + ceil(pow(strength_level + 1, 1.5));
-    }
-    int extra_damage = ceil(strength_level * 5);
-    damage += extra_damage;
-    for (int i = 1; i < equipment.size(); i++) {
-        Object * object = equipment[i];
-        if (object && i != 2) { // ignore ranged
-            damage += object->damage_bonus->roll();
-        }
+    DiceRandom & random = thread_dice_random();
+    int damage = attack_damage_bonus;
+    for (size_t i = 0; i < attack_damage_rolls.size(); i++) {
+        damage += attack_damage_rolls[i].roll(random);
     }
     return damage;
 }
 
 int Player :: getRangedAttackDamage() {
-    if (!equipment[2]) {
+    if (!equipment[SLOT_RANGED]) {
         return 0;
     }
-    Object * range = equipment[2];
-    int range_damage = range->damage_bonus->roll();
+    Object * range = equipment[SLOT_RANGED];
+    int range_damage = range->damage_bonus.roll();
     int bonus = 0;
     if (bonus) {
         bonus = dexterity_level + ceil(pow(dexterity_level + 1, 1.5));
@@ -277,6 +227,7 @@ bool Player :: canPickUpObject() {
 
 void Player :: addObjectToInventory (Object * object) {
     inventory.push_back(object);
+    updateDerivedStats();
 }
 
 string Player :: viewInventoryObjectAt(int index) {
@@ -284,7 +235,7 @@ string Player :: viewInventoryObjectAt(int index) {
 }
 
 void Player :: addSpell(Object * spell) {
-    for(int i = 0; i < spells.size(); i++) {
+    for(size_t i = 0; i < spells.size(); i++) {
         Object * existing_spell = spells[i];
         if (existing_spell->name.compare(spell->name) == 0) {
             throw "You have already learned that spell!";
@@ -295,12 +246,15 @@ void Player :: addSpell(Object * spell) {
 
 void Player :: equipObjectAt(int index) {
     Object * object = inventory[index];
-    if (object && object->type.compare("SPELL") == 0) {
+    if (object && object->object_type == OBJECT_SPELL) {
         addSpell(object);
         inventory.erase(inventory.begin() + index);
     }
     else if (object) {
-        int equipmentIndex = getIndexToSwapEquipmentWith(object->type);
+        int equipmentIndex = getIndexToSwapEquipmentWith(object->object_type);
+        if (equipmentIndex == -1) {
+            throw "You cannot wear that!";
+        }
         Object * equippedObject = equipment[equipmentIndex];
         if (equippedObject) {
             inventory[index] = equippedObject;
@@ -310,59 +264,20 @@ void Player :: equipObjectAt(int index) {
         }
         equipment[equipmentIndex] = object;
     }
+    updateDerivedStats();
 }
 
-int Player :: getIndexToSwapEquipmentWith(string type) {
-    vector<int> indexes = getIndexOfEquipmentType(type);
-    for (size_t i = 0; i < indexes.size(); i++) {
-        int index = indexes[i];
-        if (!equipment[index]) {
-            return index;
-        }
+/*
+ * The slot an object of the given type goes into: its first slot, or the
+ * second ring slot when the first ring slot is taken and the second is free.
+ */
+int Player :: getIndexToSwapEquipmentWith(ObjectType type) {
+    int index = OBJECT_TYPE_SLOTS[type];
+    if (index == SLOT_RING && equipment[SLOT_RING] && !equipment[SLOT_SECOND_RING]) {
+        return SLOT_SECOND_RING;
     }
-    return indexes[0];
+    return index;
 }
-
-vector<int> Player :: getIndexOfEquipmentType(string type) {
-    vector<int> indexes;
-    if (!type.compare("WEAPON")) {
-        indexes.push_back(0);
-    }
-    if (!type.compare("OFFHAND")) {
-        indexes.push_back(1);
-    }
-    if (!type.compare("RANGED")) {
-        indexes.push_back(2);
-    }
-    if (!type.compare("ARMOR")) {
-        indexes.push_back(3);
-    }
-    if (!type.compare("HELMET")) {
-        indexes.push_back(4);
-    }
-    if (!type.compare("CLOAK")) {
-        indexes.push_back(5);
-    }
-    if (!type.compare("GLOVES")) {
-        indexes.push_back(6);
-    }
-    if (!type.compare("BOOTS")) {
-        indexes.push_back(7);
-    }
-    if (!type.compare("AMULET")) {
-        indexes.push_back(8);
-    }
-    if (!type.compare("LIGHT")) {
-        indexes.push_back(9);
-    }
-    if (!type.compare("RING")) {
-        indexes.push_back(10);
-        indexes.push_back(11);
-    }
-    return indexes;
-}
-
-
 int Player :: getNumberOfItemsInInventory() {
     return inventory.size();
 }
@@ -396,40 +311,7 @@ string Player :: equipmentSlotToString(int index) {
 }
 
 string Player :: getEquipmentTypeFromIndex(int index) {
-    if (index == 0) {
-        return "WEAPON";
-    }
-    if (index == 1) {
-        return "OFFHAND";
-    }
-    if (index == 2) {
-        return "RANGED";
-    }
-    if (index == 3) {
-        return "ARMOR";
-    }
-    if (index == 4) {
-        return "HELMET";
-    }
-    if (index == 5) {
-        return "CLOAK";
-    }
-    if (index == 6) {
-        return "GLOVES";
-    }
-    if (index == 7) {
-        return "BOOTS";
-    }
-    if (index == 8) {
-        return "AMULET";
-    }
-    if (index == 9) {
-        return "LIGHT";
-    }
-    if (index == 10 || 11) {
-        return "RING";
-    }
-    return "Unknown";
+    return EQUIPMENT_SLOT_NAMES[index];
 }
 
 bool Player :: equipmentExistsAt(int index) {
@@ -447,27 +329,29 @@ void Player :: takeOffEquipment(int index) {
     Object * item = equipment[index];
     equipment[index] = NULL;
     inventory.push_back(item);
+    updateDerivedStats();
 }
 
 void Player :: removeInventoryItemAt(int index) {
     inventory.erase(inventory.begin() + index);
+    updateDerivedStats();
 }
 
 bool Player :: hasObject(Object * o) {
-    for (int i = 0; i < inventory.size(); i++) {
+    for (size_t i = 0; i < inventory.size(); i++) {
         Object * item = inventory[i];
         if (item && item == o) {
             return true;
         }
     }
-    for (int i = 0; i < equipment.size(); i++) {
+    for (size_t i = 0; i < equipment.size(); i++) {
         Object * item = equipment[i];
         if (item && item == o) {
             return true;
         }
     }
 
-    for (int i = 0; i < spells.size(); i++) {
+    for (size_t i = 0; i < spells.size(); i++) {
         Object * spell = spells[i];
         if (spell && spell == o) {
             return true;
@@ -477,7 +361,7 @@ bool Player :: hasObject(Object * o) {
 }
 
 bool Player :: hasRangedWeapon() {
-    return equipment[2] != NULL;
+    return equipment[SLOT_RANGED] != NULL;
 }
 
 Player :: Player() : Character() {
@@ -485,7 +369,7 @@ Player :: Player() : Character() {
     //skill_points = 0;
     skill_points = 3;
     level = 1;
-    attack_damage = new Numeric("0+1d10");
+    attack_damage = Numeric("0+1d10");
     speed = 20;
     strength_level = 0;
     dexterity_level = 0;
@@ -498,7 +382,6 @@ Player :: Player() : Character() {
     magic = max_magic;
     x = 0;
     y = 0;
-    for (int i = 0; i < 12; i++) {
-        equipment.push_back(NULL);
-    }
+    equipment.fill(NULL);
+    updateDerivedStats();
 }
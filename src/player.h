@@ -2,11 +2,41 @@
 #define __PLAYER_H
 
 #include <vector>
+#include <array>
 #include "character.h"
 #include "object.h"
+#include "dice_distribution.h"
 
 using namespace std;
 
+enum EquipmentSlot {
+    SLOT_WEAPON,
+    SLOT_OFFHAND,
+    SLOT_RANGED,
+    SLOT_ARMOR,
+    SLOT_HELMET,
+    SLOT_CLOAK,
+    SLOT_GLOVES,
+    SLOT_BOOTS,
+    SLOT_AMULET,
+    SLOT_LIGHT,
+    SLOT_RING,
+    SLOT_SECOND_RING,
+    NUMBER_OF_EQUIPMENT_SLOTS
+};
+
+// The first slot each object type is worn in, or -1 if it cannot be worn
+static constexpr int OBJECT_TYPE_SLOTS[NUMBER_OF_OBJECT_TYPES] = {
+    SLOT_WEAPON, SLOT_OFFHAND, SLOT_RANGED, SLOT_ARMOR, SLOT_HELMET,
+    SLOT_CLOAK, SLOT_GLOVES, SLOT_BOOTS, SLOT_AMULET, SLOT_LIGHT, SLOT_RING,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1
+};
+
+static constexpr const char * EQUIPMENT_SLOT_NAMES[NUMBER_OF_EQUIPMENT_SLOTS] = {
+    "WEAPON", "OFFHAND", "RANGED", "ARMOR", "HELMET", "CLOAK", "GLOVES",
+    "BOOTS", "AMULET", "LIGHT", "RING", "RING"
+};
+
 class Player : public Character {
     private:
         static const int MAX_INVENTORY_SIZE = 10;
@@ -16,15 +46,28 @@ class Player : public Character {
         static const int DEFAULT_LIGHT_RADIUS = 5;
         static const int DEFAULT_MAX_MAGIC = 50;
         vector<Object *> inventory;
-        vector<Object *> equipment;
-        int getIndexToSwapEquipmentWith(string type);
-        int getEquipmentWeight();
-        int getInventoryWeight();
+        array<Object *, NUMBER_OF_EQUIPMENT_SLOTS> equipment;
+        int getIndexToSwapEquipmentWith(ObjectType type);
         int getMaxCarryWeight();
         void addSpell(Object * spell);
 
+        // Derived stats. Recomputed by updateDerivedStats whenever equipment,
+        // inventory or skill levels change, so the getters are field loads.
+        int weight;
+        int max_carry_weight;
+        int total_speed;
+        int light_radius;
+        int equipment_defense;
+        int max_strength_defense_bonus;
+        int hit_bonus;
+        int dodge_chance;
+        int dexterity_bonus;
+        int intelligence_bonus;
+        int attack_damage_bonus;
+        vector<DiceDistribution> attack_damage_rolls;
+        void updateDerivedStats();
+
     public:
-        vector<int> getIndexOfEquipmentType(string type);
         string getEquipmentTypeFromIndex(int index);
         bool hasObject(Object *);
         string getHudInfo();
@@ -57,7 +100,6 @@ class Player : public Character {
         bool hasEnoughStaminaForAttack(int damage);
         void reduceStaminaFromDamage(int amount);
         void regenerateStamina(int turn);
-        string getStatusProgressBar(float base_percentage);
         int getDamageForSpell(Object * spell);
         void reduceMagicFromSpell(int damage);
         void regenerateMagic(int turn);
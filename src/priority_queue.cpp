@@ -1,51 +1,44 @@
+#include <algorithm>
 #include "priority_queue.h"
 
+/*
+ * Nodes are kept sorted by descending priority so the minimum is at the back
+ * and extractMin is a pop. A new node goes after every node whose priority is
+ * at least its own, so among equal priorities the newest comes out first.
+ */
+static bool comes_before(int priority, const Node & node) {
+    return priority > node.priority;
+}
+
 int PriorityQueue :: size() {
     return nodes.size();
 }
 
 void PriorityQueue :: removeFromQueue(Character * character) {
-    int index = -1;
-    for (size_t i = 0; i < nodes.size(); i++) {
-        Node existing_node = nodes[i];
-        if (!existing_node.character->id.compare(character->id)) {
-            index = i;
-            break;
+    for (size_t i = nodes.size(); i-- > 0;) {
+        if (nodes[i].character == character) {
+            nodes.erase(nodes.begin() + i);
+            return;
         }
     }
-    if (index >= 0) {
-        nodes.erase(nodes.begin() + index);
-    }
 }
 
 void PriorityQueue :: insertWithPriority(Character * character, int priority) {
     Node node;
     node.character = character;
     node.priority = priority;
-    if (nodes.size() == 0) {
-        nodes.push_back(node);
-        return;
-    }
-    for (size_t i = 0; i < nodes.size(); i++) {
-        Node existing_node = nodes[i];
-        if (priority <= existing_node.priority) {
-            nodes.insert(nodes.begin() + i, node);
-            return;
-        }
-    }
-    nodes.push_back(node);
+    nodes.insert(upper_bound(nodes.begin(), nodes.end(), priority, comes_before), node);
 }
 
 Node PriorityQueue :: extractMin() {
-    Node min = nodes[0];
-    nodes.erase(nodes.begin());
+    Node min = nodes.back();
+    nodes.pop_back();
     return min;
 }
 
 void PriorityQueue :: decreasePriority(Character * character, int priority) {
-    for (size_t i = 0; i < nodes.size(); i++) {
-        Node existing_node = nodes[i];
-        if (character->id.compare(existing_node.character->id) == 0) {
+    for (size_t i = nodes.size(); i-- > 0;) {
+        if (nodes[i].character == character) {
             nodes.erase(nodes.begin() + i);
             insertWithPriority(character, priority);
             return;
@@ -54,41 +47,22 @@ void PriorityQueue :: decreasePriority(Character * character, int priority) {
 }
 
 void PriorityQueue :: decreaseCoordPriority(struct Coordinate coord, int priority) {
-    Node node;
-    node.coord = coord;
-    node.priority = priority;
-    for (size_t i = 0; i < nodes.size(); i++) {
-        Node existing_node = nodes[i];
+    for (size_t i = nodes.size(); i-- > 0;) {
+        const Node & existing_node = nodes[i];
         if (existing_node.coord.x == coord.x && existing_node.coord.y == coord.y) {
             nodes.erase(nodes.begin() + i);
             insertCoordWithPriority(coord, priority);
             return;
         }
     }
-
 }
 
 void PriorityQueue :: insertCoordWithPriority(struct Coordinate coord, int priority) {
     Node node;
     node.coord = coord;
     node.priority = priority;
-    if (nodes.size() == 0) {
-        nodes.push_back(node);
-        return;
-    }
-    bool was_added = false;
-    for (size_t i = 0; i < nodes.size(); i++) {
-        Node existing_node = nodes[i];
-        if (priority <= existing_node.priority) {
-            nodes.insert(nodes.begin() + i, node);
-            was_added = true;
-            break;
-        }
-    }
-    if (!was_added) {
-        nodes.push_back(node);
-    }
-
+    node.character = NULL;
+    nodes.insert(upper_bound(nodes.begin(), nodes.end(), priority, comes_before), node);
 }
 
 void PriorityQueue :: clear() {
@@ -0,0 +1,292 @@
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <stdlib.h>
+#include <mutex>
+#include <new>
+#include <vector>
+#include "profiler.h"
+
+static mutex sections_mutex;
+static vector<ProfileSection *> sections;
+
+ProfileSection :: ProfileSection(const char * name) : count(0), total_ns(0), max_ns(0), last_ns(0) {
+    this->name = name;
+    for (int i = 0; i < PROFILE_BUCKETS; i++) {
+        buckets[i] = 0;
+    }
+}
+
+int ProfileSection :: bucketFor(uint64_t ns) {
+    if (ns < PROFILE_LINEAR_BUCKETS) {
+        return ns;
+    }
+    int exponent = 63 - __builtin_clzll(ns);
+    int sub_bucket = (ns >> (exponent - 3)) & (PROFILE_SUB_BUCKETS - 1);
+    return PROFILE_LINEAR_BUCKETS + (exponent - 4) * PROFILE_SUB_BUCKETS + sub_bucket;
+}
+
+/*
+ * Midpoint of the range of latencies that fall into the bucket.
+ */
+uint64_t ProfileSection :: bucketValue(int bucket) {
+    if (bucket < PROFILE_LINEAR_BUCKETS) {
+        return bucket;
+    }
+    int exponent = (bucket - PROFILE_LINEAR_BUCKETS) / PROFILE_SUB_BUCKETS + 4;
+    int sub_bucket = (bucket - PROFILE_LINEAR_BUCKETS) % PROFILE_SUB_BUCKETS;
+    uint64_t width = 1ULL << (exponent - 3);
+    return (1ULL << exponent) + sub_bucket * width + width / 2;
+}
+
+void ProfileSection :: record(uint64_t ns) {
+    buckets[bucketFor(ns)].fetch_add(1, memory_order_relaxed);
+    count.fetch_add(1, memory_order_relaxed);
+    total_ns.fetch_add(ns, memory_order_relaxed);
+    last_ns.store(ns, memory_order_relaxed);
+    uint64_t current = max_ns.load(memory_order_relaxed);
+    while (ns > current && !max_ns.compare_exchange_weak(current, ns, memory_order_relaxed)) {
+    }
+}
+
+uint64_t ProfileSection :: getCount() const {
+    return count.load(memory_order_relaxed);
+}
+
+uint64_t ProfileSection :: getPercentile(double percentile) const {
+    uint64_t total = 0;
+    for (int i = 0; i < PROFILE_BUCKETS; i++) {
+        total += buckets[i].load(memory_order_relaxed);
+    }
+    if (!total) {
+        return 0;
+    }
+    uint64_t rank = (uint64_t) (percentile / 100.0 * (total - 1)) + 1;
+    uint64_t seen = 0;
+    for (int i = 0; i < PROFILE_BUCKETS; i++) {
+        seen += buckets[i].load(memory_order_relaxed);
+        if (seen >= rank) {
+            return min(bucketValue(i), getMax());
+        }
+    }
+    return getMax();
+}
+
+uint64_t ProfileSection :: getMax() const {
+    return max_ns.load(memory_order_relaxed);
+}
+
+uint64_t ProfileSection :: getTotal() const {
+    return total_ns.load(memory_order_relaxed);
+}
+
+uint64_t ProfileSection :: getLast() const {
+    return last_ns.load(memory_order_relaxed);
+}
+
+/*
+ * Profiling builds count every operator new per thread. The counter is
+ * thread_local so threads allocating at once never share a cache line.
+ */
+static thread_local uint64_t allocations = 0;
+
+uint64_t thread_allocations() {
+    return allocations;
+}
+
+#ifdef RLG_PROFILE
+void * operator new(size_t size) {
+    allocations ++;
+    void * memory = malloc(size ? size : 1);
+    if (memory == NULL) {
+        throw bad_alloc();
+    }
+    return memory;
+}
+
+void * operator new[](size_t size) {
+    return operator new(size);
+}
+
+void operator delete(void * memory) noexcept {
+    free(memory);
+}
+
+void operator delete[](void * memory) noexcept {
+    free(memory);
+}
+#endif
+
+/*
+ * Returns the section with the given name, creating it on first use. Call
+ * sites keep the reference, so this only runs once per PROFILE_SCOPE.
+ */
+ProfileSection & profile_section(const char * name) {
+    lock_guard<mutex> lock(sections_mutex);
+    for (size_t i = 0; i < sections.size(); i++) {
+        if (strcmp(sections[i]->name, name) == 0) {
+            return *sections[i];
+        }
+    }
+    sections.push_back(new ProfileSection(name));
+    return *sections.back();
+}
+
+static string format_duration(uint64_t ns) {
+    char text[32];
+    if (ns < 10000) {
+        snprintf(text, sizeof(text), "%lluns", (unsigned long long) ns);
+    }
+    else if (ns < 10000000) {
+        snprintf(text, sizeof(text), "%.1fus", ns / 1000.0);
+    }
+    else {
+        snprintf(text, sizeof(text), "%.1fms", ns / 1000000.0);
+    }
+    return text;
+}
+
+/*
+ * One line per timed section. Empty when nothing was timed, which is always
+ * the case unless the build defines RLG_PROFILE.
+ */
+string profile_report() {
+    lock_guard<mutex> lock(sections_mutex);
+    if (!sections.size()) {
+        return "";
+    }
+    char line[160];
+    snprintf(line, sizeof(line), "%-28s %10s %10s %10s %10s %10s\n", "section", "calls", "p50", "p99", "max", "total");
+    string report = line;
+    for (size_t i = 0; i < sections.size(); i++) {
+        ProfileSection * section = sections[i];
+        snprintf(line, sizeof(line), "%-28s %10llu %10s %10s %10s %10s\n", section->name,
+                 (unsigned long long) section->getCount(),
+                 format_duration(section->getPercentile(50)).c_str(),
+                 format_duration(section->getPercentile(99)).c_str(),
+                 format_duration(section->getMax()).c_str(),
+                 format_duration(section->getTotal()).c_str());
+        report += line;
+    }
+    return report;
+}
+
+struct TraceSpan {
+    const char * name;
+    int64_t start_ns;
+    int64_t duration_ns;
+};
+
+struct TraceChunk {
+    TraceSpan spans[TRACE_CHUNK_SPANS];
+    atomic<TraceChunk *> next;
+};
+
+/*
+ * Spans of one thread. Only the owning thread appends; a chunk and its spans
+ * are written before span_count is released, so write_trace() can read up to
+ * span_count while the thread keeps running.
+ */
+struct TraceBuffer {
+    int thread_id;
+    string thread_name;
+    TraceChunk * first;
+    TraceChunk * last;
+    atomic<size_t> span_count;
+};
+
+atomic<bool> tracing_enabled(false);
+static chrono::steady_clock::time_point trace_start;
+static mutex trace_mutex;
+static vector<TraceBuffer *> trace_buffers;
+static thread_local TraceBuffer * thread_trace_buffer = NULL;
+
+static TraceChunk * new_trace_chunk() {
+    TraceChunk * chunk = new TraceChunk;
+    chunk->next = NULL;
+    return chunk;
+}
+
+static TraceBuffer * get_thread_trace_buffer() {
+    if (!thread_trace_buffer) {
+        TraceBuffer * buffer = new TraceBuffer;
+        buffer->first = new_trace_chunk();
+        buffer->last = buffer->first;
+        buffer->span_count = 0;
+        lock_guard<mutex> lock(trace_mutex);
+        buffer->thread_id = trace_buffers.size() + 1;
+        buffer->thread_name = "thread " + to_string(buffer->thread_id);
+        trace_buffers.push_back(buffer);
+        thread_trace_buffer = buffer;
+    }
+    return thread_trace_buffer;
+}
+
+void start_tracing() {
+    trace_start = chrono::steady_clock::now();
+    tracing_enabled = true;
+}
+
+void trace_thread_name(const char * name) {
+    if (!tracing_enabled.load(memory_order_acquire)) {
+        return;
+    }
+    TraceBuffer * buffer = get_thread_trace_buffer();
+    lock_guard<mutex> lock(trace_mutex);
+    buffer->thread_name = name;
+}
+
+void trace_span(const char * name, chrono::steady_clock::time_point start, chrono::steady_clock::time_point end) {
+    if (start < trace_start) {
+        return;
+    }
+    TraceBuffer * buffer = get_thread_trace_buffer();
+    size_t count = buffer->span_count.load(memory_order_relaxed);
+    if (count == TRACE_MAX_SPANS_PER_THREAD) {
+        return;
+    }
+    if (count && count % TRACE_CHUNK_SPANS == 0) {
+        TraceChunk * chunk = new_trace_chunk();
+        buffer->last->next.store(chunk, memory_order_release);
+        buffer->last = chunk;
+    }
+    TraceSpan & span = buffer->last->spans[count % TRACE_CHUNK_SPANS];
+    span.name = name;
+    span.start_ns = chrono::duration_cast<chrono::nanoseconds>(start - trace_start).count();
+    span.duration_ns = chrono::duration_cast<chrono::nanoseconds>(end - start).count();
+    buffer->span_count.store(count + 1, memory_order_release);
+}
+
+/*
+ * Writes every span recorded so far as complete ("X") events, one track per
+ * thread. Threads may keep tracing while this runs; their later spans are
+ * left out.
+ */
+bool write_trace(const string & path) {
+    FILE * file = fopen(path.c_str(), "w");
+    if (file == NULL) {
+        return false;
+    }
+    lock_guard<mutex> lock(trace_mutex);
+    fprintf(file, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+    bool first_event = true;
+    for (size_t i = 0; i < trace_buffers.size(); i++) {
+        TraceBuffer * buffer = trace_buffers[i];
+        fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+                first_event ? "" : ",\n", buffer->thread_id, buffer->thread_name.c_str());
+        first_event = false;
+        size_t count = buffer->span_count.load(memory_order_acquire);
+        TraceChunk * chunk = buffer->first;
+        for (size_t j = 0; j < count; j++) {
+            if (j && j % TRACE_CHUNK_SPANS == 0) {
+                chunk = chunk->next.load(memory_order_acquire);
+            }
+            const TraceSpan & span = chunk->spans[j % TRACE_CHUNK_SPANS];
+            fprintf(file, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+                    span.name, buffer->thread_id, span.start_ns / 1000.0, span.duration_ns / 1000.0);
+        }
+    }
+    fprintf(file, "\n]}\n");
+    fclose(file);
+    return true;
+}
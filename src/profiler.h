@@ -0,0 +1,97 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <stdint.h>
+#include <atomic>
+#include <chrono>
+#include <string>
+
+using namespace std;
+
+/*
+ * Latencies below 16ns get a bucket each; above that every power of two is
+ * split into 8 buckets, so percentiles are within 12.5%.
+ */
+#define PROFILE_LINEAR_BUCKETS 16
+#define PROFILE_SUB_BUCKETS 8
+#define PROFILE_BUCKETS (PROFILE_LINEAR_BUCKETS + (64 - 4) * PROFILE_SUB_BUCKETS)
+
+/*
+ * Latency histogram of one timed section. Safe to record into from several
+ * threads at once; the distance passes also run in the background.
+ */
+class ProfileSection {
+    private:
+        atomic<uint64_t> buckets[PROFILE_BUCKETS];
+        atomic<uint64_t> count;
+        atomic<uint64_t> total_ns;
+        atomic<uint64_t> max_ns;
+        atomic<uint64_t> last_ns;
+        static int bucketFor(uint64_t ns);
+        static uint64_t bucketValue(int bucket);
+
+    public:
+        const char * name;
+        void record(uint64_t ns);
+        uint64_t getCount() const;
+        uint64_t getPercentile(double percentile) const;
+        uint64_t getMax() const;
+        uint64_t getTotal() const;
+        uint64_t getLast() const;
+        ProfileSection(const char * name);
+};
+
+ProfileSection & profile_section(const char * name);
+string profile_report();
+uint64_t thread_allocations();
+
+/*
+ * Tracing keeps every timed scope as a span in a buffer owned by the thread
+ * that ran it, and write_trace() dumps them as a Chrome trace-event file
+ * (chrome://tracing, ui.perfetto.dev). Threads only ever append to their own
+ * buffer, so recording takes no locks.
+ */
+#define TRACE_CHUNK_SPANS 4096
+#define TRACE_MAX_SPANS_PER_THREAD (1 << 20)
+
+extern atomic<bool> tracing_enabled;
+
+void start_tracing();
+void trace_thread_name(const char * name);
+void trace_span(const char * name, chrono::steady_clock::time_point start, chrono::steady_clock::time_point end);
+bool write_trace(const string & path);
+
+class ScopedTimer {
+    private:
+        ProfileSection & section;
+        chrono::steady_clock::time_point start;
+
+    public:
+        ScopedTimer(ProfileSection & section) : section(section), start(chrono::steady_clock::now()) {}
+        ~ScopedTimer() {
+            chrono::steady_clock::time_point end = chrono::steady_clock::now();
+            section.record(chrono::duration_cast<chrono::nanoseconds>(end - start).count());
+            if (tracing_enabled.load(memory_order_acquire)) {
+                trace_span(section.name, start, end);
+            }
+        }
+};
+
+/*
+ * PROFILE_SCOPE("name") times the rest of the enclosing block, and traces it
+ * while tracing is on. It compiles to nothing unless the build defines
+ * RLG_PROFILE (make PROFILE=1).
+ */
+#ifdef RLG_PROFILE
+#define PROFILING_COMPILED_IN 1
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+#define PROFILE_SCOPE(name) \
+    static ProfileSection & PROFILE_CONCAT(profile_section_, __LINE__) = profile_section(name); \
+    ScopedTimer PROFILE_CONCAT(profile_timer_, __LINE__)(PROFILE_CONCAT(profile_section_, __LINE__))
+#else
+#define PROFILING_COMPILED_IN 0
+#define PROFILE_SCOPE(name)
+#endif
+
+#endif
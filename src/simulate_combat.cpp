@@ -0,0 +1,440 @@
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <iostream>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+
+#include "util.h"
+#include "player.h"
+#include "monster.h"
+#include "monster_template.h"
+#include "object_template.h"
+#include "monster_description_parser.h"
+#include "object_description_parser.h"
+#include "dice_distribution.h"
+
+using namespace std;
+
+#define MAX_FIGHT_TURNS 100000
+#define FIGHTS_PER_CHUNK 4096
+#define UNARMED_ATTACK_COST 3
+#define ROLL_BUFFER_SIZE 256
+
+/*
+ * Outcome counts and histograms for the fights against one monster template.
+ * Histograms are indexed by value and grow as needed.
+ */
+struct FightStats {
+    long fights;
+    long wins;
+    long losses;
+    long timeouts;
+    long hits;
+    long damage_dealt;
+    vector<long> turns_to_kill;
+    vector<long> damage_taken;
+};
+
+/*
+ * Rolls of one Numeric, filled ROLL_BUFFER_SIZE at a time from its compiled
+ * table. Every chunk starts a fresh buffer after reseeding, so the rolls a
+ * fight sees do not depend on the number of threads.
+ */
+class RollBuffer {
+    private:
+        Numeric numeric;
+        int rolls[ROLL_BUFFER_SIZE];
+        int next;
+
+    public:
+        int roll() {
+            if (next == ROLL_BUFFER_SIZE) {
+                numeric.roll(ROLL_BUFFER_SIZE, rolls);
+                next = 0;
+            }
+            return rolls[next++];
+        }
+        RollBuffer(Numeric numeric) : numeric(numeric), next(ROLL_BUFFER_SIZE) {};
+};
+
+static int fights_per_monster = 100000;
+static unsigned int base_seed = 0;
+static int number_of_threads = 0;
+static string monster_file = "";
+static string object_file = "";
+static vector<string> equipment_names;
+static int strength_level = 0;
+static int dexterity_level = 0;
+static int intelligence_level = 0;
+static vector<MonsterTemplate> monster_templates;
+static vector<ObjectTemplate> object_templates;
+static vector<struct FightStats> monster_stats;
+static mutex stats_mutex;
+static atomic<int> next_chunk(0);
+static int chunks_per_monster = 0;
+
+void print_usage();
+void load_templates();
+void simulate_chunks();
+Player * make_player();
+void destroy_player(Player * player);
+void simulate_fight(Player * player, MonsterTemplate & monster_template, RollBuffer & monster_attack_rolls, EntityPool<Monster> & monster_pool, struct FightStats & stats);
+void add_to_histogram(vector<long> & histogram, int value);
+void merge_stats(struct FightStats & into, const struct FightStats & from);
+int get_percentile(const vector<long> & histogram, long count, double fraction);
+double get_mean(const vector<long> & histogram, long count);
+void print_stats(double seconds);
+
+int main(int argc, char *args[]) {
+    struct option longopts[] = { {"fights", required_argument, NULL, 'n'},
+        {"seed", required_argument, NULL, 's'},
+        {"threads", required_argument, NULL, 't'},
+        {"monsters", required_argument, NULL, 'm'},
+        {"objects", required_argument, NULL, 'o'},
+        {"equip", required_argument, NULL, 'e'},
+        {"strength", required_argument, NULL, 'S'},
+        {"dexterity", required_argument, NULL, 'D'},
+        {"intelligence", required_argument, NULL, 'I'},
+        {"help", no_argument, NULL, 'h'},
+        {0, 0, 0, 0}
+    };
+    int c;
+    while((c = getopt_long(argc, args, "n:s:t:m:o:e:S:D:I:h", longopts, NULL)) != -1) {
+        switch(c) {
+            case 'n':
+                fights_per_monster = atoi(optarg);
+                break;
+            case 's':
+                base_seed = strtoul(optarg, NULL, 10);
+                break;
+            case 't':
+                number_of_threads = atoi(optarg);
+                break;
+            case 'm':
+                monster_file = optarg;
+                break;
+            case 'o':
+                object_file = optarg;
+                break;
+            case 'e':
+                equipment_names.push_back(optarg);
+                break;
+            case 'S':
+                strength_level = atoi(optarg);
+                break;
+            case 'D':
+                dexterity_level = atoi(optarg);
+                break;
+            case 'I':
+                intelligence_level = atoi(optarg);
+                break;
+            default:
+                print_usage();
+                exit(0);
+        }
+    }
+    if (fights_per_monster < 1) {
+        print_usage();
+        exit(1);
+    }
+    if (number_of_threads < 1) {
+        number_of_threads = thread::hardware_concurrency();
+        if (number_of_threads < 1) {
+            number_of_threads = 1;
+        }
+    }
+    load_templates();
+    chunks_per_monster = (fights_per_monster + FIGHTS_PER_CHUNK - 1) / FIGHTS_PER_CHUNK;
+    monster_stats.resize(monster_templates.size());
+
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    vector<thread> workers;
+    for (int i = 0; i < number_of_threads; i++) {
+        workers.push_back(thread(simulate_chunks));
+    }
+    for (size_t i = 0; i < workers.size(); i++) {
+        workers[i].join();
+    }
+    chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+    print_stats(elapsed.count());
+    return 0;
+}
+
+void print_usage() {
+    printf("usage: simulate_combat [--fights=<fights per monster>] [--seed=<base seed>] [--threads=<number of threads>] [--monsters=<file>] [--objects=<file>] [--equip=<object name>]... [--strength=<level>] [--dexterity=<level>] [--intelligence=<level>]\n");
+}
+
+void load_templates() {
+    string directory = string(getenv("HOME")) + "/.rlg327/";
+    if (!monster_file.length()) {
+        monster_file = directory + "monster_desc.txt";
+    }
+    if (!object_file.length()) {
+        object_file = directory + "object_desc.txt";
+    }
+    MonsterDescriptionParser monster_parser = MonsterDescriptionParser(monster_file);
+    try {
+        monster_parser.parseFile();
+    }
+    catch(const char * e) {
+        cout << "Error reading monster file: " << e << endl;
+        exit(1);
+    }
+    monster_templates = monster_parser.getMonsterTemplates();
+    if (!monster_templates.size()) {
+        cout << "No monsters in " << monster_file << endl;
+        exit(1);
+    }
+    if (!equipment_names.size()) {
+        return;
+    }
+    ObjectDescriptionParser object_parser = ObjectDescriptionParser(object_file);
+    try {
+        object_parser.parseFile();
+    }
+    catch(const char * e) {
+        cout << "Error reading object file: " << e << endl;
+        exit(2);
+    }
+    object_templates = object_parser.getObjectTemplates();
+    for (size_t i = 0; i < equipment_names.size(); i++) {
+        bool found = false;
+        for (size_t j = 0; j < object_templates.size(); j++) {
+            found = found || object_templates[j].name.compare(equipment_names[i]) == 0;
+        }
+        if (!found) {
+            cout << "No object named " << equipment_names[i] << " in " << object_file << endl;
+            exit(2);
+        }
+    }
+}
+
+/*
+ * Worker loop. Fights are handed out in chunks, and chunk i always reseeds
+ * the thread's generators from base_seed + i, so the totals do not depend on
+ * the number of threads. The loadout is rolled once per chunk.
+ */
+void simulate_chunks() {
+    int total_chunks = chunks_per_monster * monster_templates.size();
+    vector<struct FightStats> local_stats(monster_templates.size());
+    EntityPool<Monster> monster_pool;
+    int chunk;
+    while ((chunk = next_chunk++) < total_chunks) {
+        seed_random_int(base_seed + chunk);
+        thread_dice_random() = DiceRandom(base_seed + chunk);
+        int monster_index = chunk / chunks_per_monster;
+        int first_fight = (chunk % chunks_per_monster) * FIGHTS_PER_CHUNK;
+        int fights = min(FIGHTS_PER_CHUNK, fights_per_monster - first_fight);
+        Player * player = make_player();
+        MonsterTemplate & monster_template = monster_templates[monster_index];
+        RollBuffer monster_attack_rolls(monster_template.getAttackDamage());
+        for (int i = 0; i < fights; i++) {
+            simulate_fight(player, monster_template, monster_attack_rolls, monster_pool, local_stats[monster_index]);
+        }
+        destroy_player(player);
+    }
+    lock_guard<mutex> lock(stats_mutex);
+    for (size_t i = 0; i < local_stats.size(); i++) {
+        merge_stats(monster_stats[i], local_stats[i]);
+    }
+}
+
+Player * make_player() {
+    Player * player = new Player();
+    for (int i = 0; i < strength_level; i++) {
+        player->levelUpSkill("Strength");
+    }
+    for (int i = 0; i < dexterity_level; i++) {
+        player->levelUpSkill("Dexterity");
+    }
+    for (int i = 0; i < intelligence_level; i++) {
+        player->levelUpSkill("Intelligence");
+    }
+    for (size_t i = 0; i < equipment_names.size(); i++) {
+        for (size_t j = 0; j < object_templates.size(); j++) {
+            if (object_templates[j].name.compare(equipment_names[i]) == 0) {
+                player->addObjectToInventory(object_templates[j].makeObject());
+                try {
+                    player->equipObjectAt(player->getNumberOfItemsInInventory() - 1);
+                }
+                catch(const char * e) {
+                    cout << equipment_names[i] << ": " << e << endl;
+                    exit(2);
+                }
+                break;
+            }
+        }
+    }
+    return player;
+}
+
+void destroy_player(Player * player) {
+    for (int i = 0; i < player->equipmentSlots(); i++) {
+        delete player->getEquipmentAt(i);
+    }
+    while (player->getNumberOfItemsInInventory()) {
+        delete player->getInventoryItemAt(0);
+        player->removeInventoryItemAt(0);
+    }
+    for (size_t i = 0; i < player->spells.size(); i++) {
+        delete player->spells[i];
+    }
+    delete player;
+}
+
+/*
+ * One melee fight to the death, following the game loop: whoever has the
+ * lowest next turn acts, waits 1000 / speed, and regenerates. The player
+ * attacks whenever they have the stamina and rests otherwise; the monster is
+ * always adjacent and always attacks. On a tie the character that acted
+ * last goes again, as it does in the game's priority queue. The monster's
+ * attacks come from the chunk's buffer of its template's attack dice.
+ */
+void simulate_fight(Player * player, MonsterTemplate & monster_template, RollBuffer & monster_attack_rolls, EntityPool<Monster> & monster_pool, struct FightStats & stats) {
+    Monster * monster = monster_template.makeMonster(monster_pool);
+    player->hitpoints = player->max_hitpoints;
+    player->stamina_points = player->max_stamina_points;
+    player->magic = player->max_magic;
+    player->turn_health_regenerated = 0;
+    Object * weapon = player->getEquipmentAt(SLOT_WEAPON);
+    int attack_cost = weapon ? weapon->cost : UNARMED_ATTACK_COST;
+    int player_turn = 0;
+    int monster_turn = 1;
+    bool player_acted_last = true;
+    int player_turns = 0;
+    int damage_taken = 0;
+    int game_turn = 0;
+    stats.fights ++;
+    while (true) {
+        if (game_turn >= MAX_FIGHT_TURNS) {
+            stats.timeouts ++;
+            break;
+        }
+        if (player_turn < monster_turn || (player_turn == monster_turn && player_acted_last)) {
+            player_turns ++;
+            if (player->hasEnoughStaminaForAttack(attack_cost)) {
+                int damage = player->getAttackDamage();
+                player->reduceStaminaFromDamage(attack_cost);
+                if (monster->hitWillConnect()) {
+                    monster->damage(damage);
+                    stats.hits ++;
+                    stats.damage_dealt += damage;
+                }
+            }
+            int speed = max(player->getSpeed(), 1);
+            player->regenerateStamina(game_turn);
+            player->regenerateMagic(game_turn);
+            player->regenerateHealth(game_turn);
+            player_turn += 1000 / speed;
+            player_acted_last = true;
+            if (!monster->isAlive()) {
+                stats.wins ++;
+                add_to_histogram(stats.turns_to_kill, player_turns);
+                break;
+            }
+        }
+        else {
+            if (!player->willDodgeAttack() && player->hitWillConnect()) {
+                damage_taken += player->damage(monster_attack_rolls.roll());
+            }
+            monster->regenerateHealth(game_turn);
+            monster_turn += 1000 / max(monster->speed, 1);
+            player_acted_last = false;
+            if (!player->isAlive()) {
+                stats.losses ++;
+                break;
+            }
+        }
+        game_turn ++;
+    }
+    add_to_histogram(stats.damage_taken, max(damage_taken, 0));
+    monster_pool.destroy(monster);
+}
+
+void add_to_histogram(vector<long> & histogram, int value) {
+    if ((size_t) value >= histogram.size()) {
+        histogram.resize(value + 1, 0);
+    }
+    histogram[value] ++;
+}
+
+void merge_stats(struct FightStats & into, const struct FightStats & from) {
+    into.fights += from.fights;
+    into.wins += from.wins;
+    into.losses += from.losses;
+    into.timeouts += from.timeouts;
+    into.hits += from.hits;
+    into.damage_dealt += from.damage_dealt;
+    for (size_t i = 0; i < from.turns_to_kill.size(); i++) {
+        if (from.turns_to_kill[i]) {
+            if (i >= into.turns_to_kill.size()) {
+                into.turns_to_kill.resize(i + 1, 0);
+            }
+            into.turns_to_kill[i] += from.turns_to_kill[i];
+        }
+    }
+    for (size_t i = 0; i < from.damage_taken.size(); i++) {
+        if (from.damage_taken[i]) {
+            if (i >= into.damage_taken.size()) {
+                into.damage_taken.resize(i + 1, 0);
+            }
+            into.damage_taken[i] += from.damage_taken[i];
+        }
+    }
+}
+
+int get_percentile(const vector<long> & histogram, long count, double fraction) {
+    long seen = 0;
+    for (size_t i = 0; i < histogram.size(); i++) {
+        seen += histogram[i];
+        if (seen > 0 && seen >= fraction * count) {
+            return i;
+        }
+    }
+    return 0;
+}
+
+double get_mean(const vector<long> & histogram, long count) {
+    if (!count) {
+        return 0;
+    }
+    double total = 0;
+    for (size_t i = 0; i < histogram.size(); i++) {
+        total += (double) i * histogram[i];
+    }
+    return total / count;
+}
+
+void print_stats(double seconds) {
+    long total_fights = 0;
+    printf("%-24s %7s %7s %7s   %-20s %8s   %-20s\n", "Monster", "Win%", "Loss%", "Timeout%",
+            "Turns to kill", "Dmg/hit", "Damage taken");
+    printf("%-24s %7s %7s %7s   %-20s %8s   %-20s\n", "", "", "", "",
+            "mean / p50 / p90", "mean", "mean / p50 / p90");
+    for (size_t i = 0; i < monster_stats.size(); i++) {
+        const struct FightStats & stats = monster_stats[i];
+        double fights = stats.fights;
+        total_fights += stats.fights;
+        char turns[32] = "-";
+        if (stats.wins) {
+            snprintf(turns, sizeof(turns), "%.1f / %d / %d", get_mean(stats.turns_to_kill, stats.wins),
+                    get_percentile(stats.turns_to_kill, stats.wins, 0.5),
+                    get_percentile(stats.turns_to_kill, stats.wins, 0.9));
+        }
+        char taken[32];
+        snprintf(taken, sizeof(taken), "%.1f / %d / %d", get_mean(stats.damage_taken, stats.fights),
+                get_percentile(stats.damage_taken, stats.fights, 0.5),
+                get_percentile(stats.damage_taken, stats.fights, 0.9));
+        printf("%-24.24s %6.2f%% %6.2f%% %7.2f%%   %-20s %8.1f   %-20s\n",
+                monster_templates[i].getName().c_str(), 100 * stats.wins / fights,
+                100 * stats.losses / fights, 100 * stats.timeouts / fights, turns,
+                stats.hits ? (double) stats.damage_dealt / stats.hits : 0.0, taken);
+    }
+    printf("Simulated %ld fights on %d threads in %.3f s (%.0f fights/s)\n",
+            total_fights, number_of_threads, seconds, total_fights / seconds);
+}
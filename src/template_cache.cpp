@@ -0,0 +1,333 @@
+#include <string.h>
+#include <stdio.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "template_cache.h"
+
+static const string CACHE_MARKER = "RLG327-TCACHE";
+// Marker, version, parser version, kind, source size, source mtime (seconds
+// and nanoseconds), template count, payload length and payload checksum
+static const size_t HEADER_LENGTH = 13 + 4 + 4 + 4 + 8 + 8 + 8 + 4 + 4 + 4;
+
+/*
+ * Reads values straight out of a mapped cache, throwing if a read would run
+ * past the end of the payload. Strings are assigned from the mapping into
+ * their destination without an intermediate copy.
+ */
+class CacheReader {
+    private:
+        const uint8_t * data;
+        size_t length;
+        size_t offset;
+
+    public:
+        void read(void * value, size_t size) {
+            if (offset + size > length) {
+                throw "Template cache is truncated";
+            }
+            memcpy(value, data + offset, size);
+            offset += size;
+        }
+        int32_t readInt() {
+            int32_t value;
+            read(&value, 4);
+            return value;
+        }
+        void readString(string & str) {
+            uint32_t size = readInt();
+            if (offset + size > length) {
+                throw "Template cache is truncated";
+            }
+            str.assign((const char *) data + offset, size);
+            offset += size;
+        }
+        string readString() {
+            string str;
+            readString(str);
+            return str;
+        }
+        Numeric readNumeric() {
+            Numeric numeric;
+            numeric.base = readInt();
+            numeric.dice = readInt();
+            numeric.sides = readInt();
+            return numeric;
+        }
+        vector<string> readStrings() {
+            uint32_t count = readInt();
+            if (count > length - offset) {
+                throw "Template cache is truncated";
+            }
+            vector<string> strings(count);
+            for (uint32_t i = 0; i < count; i++) {
+                readString(strings[i]);
+            }
+            return strings;
+        }
+        CacheReader(const uint8_t * data, size_t length) : data(data), length(length), offset(0) {};
+};
+
+static void write_bytes(vector<uint8_t> & buffer, const void * value, size_t size) {
+    const uint8_t * bytes = (const uint8_t *) value;
+    buffer.insert(buffer.end(), bytes, bytes + size);
+}
+
+static void write_int(vector<uint8_t> & buffer, int32_t value) {
+    write_bytes(buffer, &value, 4);
+}
+
+static void write_string(vector<uint8_t> & buffer, const string & str) {
+    write_int(buffer, str.length());
+    buffer.insert(buffer.end(), str.begin(), str.end());
+}
+
+static void write_numeric(vector<uint8_t> & buffer, const Numeric & numeric) {
+    write_int(buffer, numeric.base);
+    write_int(buffer, numeric.dice);
+    write_int(buffer, numeric.sides);
+}
+
+static void write_strings(vector<uint8_t> & buffer, const vector<string> & strings) {
+    write_int(buffer, strings.size());
+    for (size_t i = 0; i < strings.size(); i++) {
+        write_string(buffer, strings[i]);
+    }
+}
+
+// 32-bit FNV-1a
+static uint32_t checksum(const uint8_t * data, size_t length) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < length; i++) {
+        hash ^= data[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+TemplateCache :: TemplateCache(string cache_path, string source_path) {
+    this->cache_path = cache_path;
+    this->source_path = source_path;
+}
+
+bool TemplateCache :: getSourceStamp(int64_t & size, int64_t & mtime_seconds, int64_t & mtime_nanoseconds) {
+    struct stat source_stat;
+    if (stat(source_path.c_str(), &source_stat) != 0) {
+        return false;
+    }
+    size = source_stat.st_size;
+    mtime_seconds = source_stat.st_mtim.tv_sec;
+    mtime_nanoseconds = source_stat.st_mtim.tv_nsec;
+    return true;
+}
+
+/*
+ * Maps the cache file and checks its header against the source file. Returns
+ * the start of the mapping, or NULL if the cache is missing, stale, of the
+ * wrong kind or corrupt. mapped_length is the length to pass to munmap.
+ */
+const uint8_t * TemplateCache :: mapCache(uint32_t kind, size_t & mapped_length, uint32_t & count) {
+    int64_t source_size;
+    int64_t source_seconds;
+    int64_t source_nanoseconds;
+    if (!getSourceStamp(source_size, source_seconds, source_nanoseconds)) {
+        return NULL;
+    }
+    int fd = open(cache_path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return NULL;
+    }
+    struct stat cache_stat;
+    if (fstat(fd, &cache_stat) != 0 || (size_t) cache_stat.st_size < HEADER_LENGTH) {
+        close(fd);
+        return NULL;
+    }
+    mapped_length = cache_stat.st_size;
+    void * mapping = mmap(NULL, mapped_length, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        return NULL;
+    }
+    const uint8_t * data = (const uint8_t *) mapping;
+    CacheReader header(data, HEADER_LENGTH);
+    char marker[13];
+    header.read(marker, 13);
+    uint32_t version = header.readInt();
+    uint32_t parser_version = header.readInt();
+    uint32_t cache_kind = header.readInt();
+    int64_t size;
+    int64_t seconds;
+    int64_t nanoseconds;
+    header.read(&size, 8);
+    header.read(&seconds, 8);
+    header.read(&nanoseconds, 8);
+    count = header.readInt();
+    uint32_t payload_length = header.readInt();
+    uint32_t payload_checksum = header.readInt();
+    bool valid = CACHE_MARKER.compare(0, 13, marker, 13) == 0 && version == VERSION &&
+        parser_version == PARSER_VERSION && cache_kind == kind && size == source_size && seconds == source_seconds &&
+        nanoseconds == source_nanoseconds && HEADER_LENGTH + payload_length == mapped_length && count <= payload_length &&
+        checksum(data + HEADER_LENGTH, payload_length) == payload_checksum;
+    if (!valid) {
+        munmap(mapping, mapped_length);
+        return NULL;
+    }
+    return data;
+}
+
+void TemplateCache :: savePayload(uint32_t kind, const vector<uint8_t> & payload, uint32_t count) {
+    int64_t size;
+    int64_t seconds;
+    int64_t nanoseconds;
+    if (!getSourceStamp(size, seconds, nanoseconds)) {
+        return;
+    }
+    vector<uint8_t> header;
+    uint32_t version = VERSION;
+    uint32_t parser_version = PARSER_VERSION;
+    uint32_t payload_length = payload.size();
+    uint32_t payload_checksum = checksum(payload.data(), payload.size());
+    write_bytes(header, CACHE_MARKER.c_str(), 13);
+    write_bytes(header, &version, 4);
+    write_bytes(header, &parser_version, 4);
+    write_bytes(header, &kind, 4);
+    write_bytes(header, &size, 8);
+    write_bytes(header, &seconds, 8);
+    write_bytes(header, &nanoseconds, 8);
+    write_bytes(header, &count, 4);
+    write_bytes(header, &payload_length, 4);
+    write_bytes(header, &payload_checksum, 4);
+
+    // Written to a temporary file and renamed so a reader never sees half a cache
+    string temporary_path = cache_path + ".tmp";
+    FILE * fp = fopen(temporary_path.c_str(), "wb");
+    if (fp == NULL) {
+        return;
+    }
+    bool written = fwrite(header.data(), 1, header.size(), fp) == header.size() &&
+        fwrite(payload.data(), 1, payload.size(), fp) == payload.size();
+    if (fclose(fp) != 0 || !written) {
+        remove(temporary_path.c_str());
+        return;
+    }
+    rename(temporary_path.c_str(), cache_path.c_str());
+}
+
+/*
+ * Decodes each record from the mapping directly into its slot in templates.
+ * On failure templates is left empty for the caller to refill from the text
+ * file.
+ */
+bool TemplateCache :: load(vector<MonsterTemplate> & templates) {
+    size_t mapped_length;
+    uint32_t count;
+    const uint8_t * data = mapCache(MONSTER_TEMPLATES, mapped_length, count);
+    if (!data) {
+        return false;
+    }
+    bool success = true;
+    try {
+        CacheReader reader(data + HEADER_LENGTH, mapped_length - HEADER_LENGTH);
+        templates.clear();
+        templates.resize(count);
+        for (uint32_t i = 0; i < count; i++) {
+            MonsterTemplate & monster_template = templates[i];
+            monster_template.setName(reader.readString());
+            monster_template.setDescription(reader.readString());
+            monster_template.setColors(reader.readStrings());
+            char symbol;
+            reader.read(&symbol, 1);
+            monster_template.setSymbol(symbol);
+            monster_template.setSpeed(reader.readNumeric());
+            monster_template.setAbilities(reader.readStrings());
+            monster_template.setHitpoints(reader.readNumeric());
+            monster_template.setAttackDamage(reader.readNumeric());
+            monster_template.setExperience(reader.readNumeric());
+        }
+    }
+    catch(const char * e) {
+        templates.clear();
+        success = false;
+    }
+    munmap((void *) data, mapped_length);
+    return success;
+}
+
+void TemplateCache :: save(vector<MonsterTemplate> & templates) {
+    vector<uint8_t> payload;
+    for (size_t i = 0; i < templates.size(); i++) {
+        MonsterTemplate & monster_template = templates[i];
+        write_string(payload, monster_template.getName());
+        write_string(payload, monster_template.getDescription());
+        write_strings(payload, monster_template.getColors());
+        char symbol = monster_template.getSymbol();
+        write_bytes(payload, &symbol, 1);
+        write_numeric(payload, monster_template.getSpeed());
+        write_strings(payload, monster_template.getAbilities());
+        write_numeric(payload, monster_template.getHitpoints());
+        write_numeric(payload, monster_template.getAttackDamage());
+        write_numeric(payload, monster_template.getExperience());
+    }
+    savePayload(MONSTER_TEMPLATES, payload, templates.size());
+}
+
+bool TemplateCache :: load(vector<ObjectTemplate> & templates) {
+    size_t mapped_length;
+    uint32_t count;
+    const uint8_t * data = mapCache(OBJECT_TEMPLATES, mapped_length, count);
+    if (!data) {
+        return false;
+    }
+    bool success = true;
+    try {
+        CacheReader reader(data + HEADER_LENGTH, mapped_length - HEADER_LENGTH);
+        templates.clear();
+        templates.resize(count);
+        for (uint32_t i = 0; i < count; i++) {
+            ObjectTemplate & object_template = templates[i];
+            reader.readString(object_template.name);
+            reader.readString(object_template.description);
+            reader.readString(object_template.type);
+            object_template.object_type = parseObjectType(object_template.type);
+            reader.readString(object_template.color);
+            object_template.hit_bonus = reader.readNumeric();
+            object_template.damage_bonus = reader.readNumeric();
+            object_template.dodge_bonus = reader.readNumeric();
+            object_template.defense_bonus = reader.readNumeric();
+            object_template.weight = reader.readNumeric();
+            object_template.speed_bonus = reader.readNumeric();
+            object_template.special_attribute = reader.readNumeric();
+            object_template.value = reader.readNumeric();
+            object_template.cost = reader.readNumeric();
+            object_template.compileRolls();
+        }
+    }
+    catch(const char * e) {
+        templates.clear();
+        success = false;
+    }
+    munmap((void *) data, mapped_length);
+    return success;
+}
+
+void TemplateCache :: save(vector<ObjectTemplate> & templates) {
+    vector<uint8_t> payload;
+    for (size_t i = 0; i < templates.size(); i++) {
+        ObjectTemplate & object_template = templates[i];
+        write_string(payload, object_template.name);
+        write_string(payload, object_template.description);
+        write_string(payload, object_template.type);
+        write_string(payload, object_template.color);
+        write_numeric(payload, object_template.hit_bonus);
+        write_numeric(payload, object_template.damage_bonus);
+        write_numeric(payload, object_template.dodge_bonus);
+        write_numeric(payload, object_template.defense_bonus);
+        write_numeric(payload, object_template.weight);
+        write_numeric(payload, object_template.speed_bonus);
+        write_numeric(payload, object_template.special_attribute);
+        write_numeric(payload, object_template.value);
+        write_numeric(payload, object_template.cost);
+    }
+    savePayload(OBJECT_TEMPLATES, payload, templates.size());
+}
@@ -0,0 +1,41 @@
+#ifndef TEMPLATE_CACHE_H
+#define TEMPLATE_CACHE_H
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include "monster_template.h"
+#include "object_template.h"
+
+using namespace std;
+
+/*
+ * A compiled binary copy of a monster or object description file. The cache
+ * records the size and modification time of the text file it was built from
+ * and a checksum of its own contents; load() refuses a cache that does not
+ * match, and the caller falls back to the text parser and save()s a new one.
+ * PARSER_VERSION is stored alongside the stamp and must be bumped whenever
+ * the description parsers change how a file is interpreted, since the
+ * source file itself is unchanged in that case.
+ */
+class TemplateCache {
+    private:
+        static const uint32_t VERSION = 2;
+        static const uint32_t PARSER_VERSION = 2;
+        static const uint32_t MONSTER_TEMPLATES = 1;
+        static const uint32_t OBJECT_TEMPLATES = 2;
+        string cache_path;
+        string source_path;
+        bool getSourceStamp(int64_t & size, int64_t & mtime_seconds, int64_t & mtime_nanoseconds);
+        const uint8_t * mapCache(uint32_t kind, size_t & mapped_length, uint32_t & count);
+        void savePayload(uint32_t kind, const vector<uint8_t> & payload, uint32_t count);
+
+    public:
+        bool load(vector<MonsterTemplate> & templates);
+        bool load(vector<ObjectTemplate> & templates);
+        void save(vector<MonsterTemplate> & templates);
+        void save(vector<ObjectTemplate> & templates);
+        TemplateCache(string cache_path, string source_path);
+};
+
+#endif
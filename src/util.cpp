@@ -51,13 +51,24 @@ string vector_to_string(vector<string> vec) {
 }
 
 
+static mt19937 & thread_rng() {
+    static thread_local mt19937 rng(random_device{}());
+    return rng;
+}
+
+/*
+ * Reseeds random_int for the calling thread only, for reproducible runs.
+ */
+void seed_random_int(unsigned int seed) {
+    thread_rng().seed(seed);
+}
+
 /*
  * This random_int function was taken online. Source:
  * http://stackoverflow.com/a/19728404
  */
 int random_int(int min_num, int max_num) {
-    random_device rd;
-    mt19937 rng(rd());
+    mt19937 & rng = thread_rng();
     if (min_num > max_num) {
        int tmp = min_num;
        min_num = max_num;
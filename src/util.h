@@ -26,6 +26,8 @@ string vector_to_string(vector<string> vec);
 
 int random_int(int min_num, int max_num);
 
+void seed_random_int(unsigned int seed);
+
 vector<int> getKeysFromMap(map<int, string> m);
 
 #endif